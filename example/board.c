@@ -3,7 +3,7 @@
 
 #define TAG "board"
 
-static int board_test(void)
+static int __xf_init board_test(void)
 {
     XF_LOGI(TAG, "hello, board");
 
@@ -0,0 +1,24 @@
+#include "xf_utils.h"
+#include "xf_init.hpp"
+
+#define TAG "cpp"
+
+template <typename T>
+struct cpp_component {
+    static int init(void)
+    {
+        XF_LOGI(TAG, "hello, cpp component<%u>", (unsigned)sizeof(T));
+
+        return 0;
+    }
+};
+
+static constexpr xf::init::exporter<xf::init::level::component, &cpp_component<int>::init> s_cpp_component{};
+
+#if __cplusplus >= 202002L
+static constexpr char s_cpp_app_name[] = "cpp_app_test";
+static constexpr xf::init::exporter<xf::init::level::app, [] {
+    XF_LOGI(TAG, "hello, cpp app");
+    return 0;
+}, s_cpp_app_name> s_cpp_app{};
+#endif
@@ -11,3 +11,30 @@ static int device_test(void)
 }
 
 XF_INIT_EXPORT_DEVICE(device_test);
+
+static int device_suspend(void)
+{
+    XF_LOGI(TAG, "device suspend");
+
+    return 0;
+}
+
+XF_INIT_EXPORT_SUSPEND(device_suspend, DEVICE);
+
+static int device_resume(void)
+{
+    XF_LOGI(TAG, "device resume");
+
+    return 0;
+}
+
+XF_INIT_EXPORT_RESUME(device_resume, DEVICE);
+
+static int device_postfork(void)
+{
+    XF_LOGI(TAG, "device postfork");
+
+    return 0;
+}
+
+XF_INIT_EXPORT_POSTFORK(device_postfork, DEVICE);
@@ -28,6 +28,12 @@
 int main(void)
 {
     xf_init();
+#if XF_INIT_ENABLE_RELEASE
+    xf_init_release();
+#endif
+
+    xf_suspend();
+    xf_resume();
 }
 
 /* ==================== [Static Functions] ================================== */
@@ -0,0 +1,248 @@
+/**
+ * @file xf_init_arena.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化期间使用的 bump 分配器。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_arena.h"
+
+#if XF_INIT_ENABLE_ARENA
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/mman.h>
+#   include <unistd.h>
+#   define XF_INIT_ARENA_USE_MMAP   1
+#else
+#   define XF_INIT_ARENA_USE_MMAP   0
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "arena"
+
+#define XF_INIT_ARENA_HUGE_PAGE_SIZE    (2u * 1024u * 1024u)
+
+/* 超过块大小的 1/4 时直接从 arena 分配, 避免浪费块的剩余空间 */
+#define XF_INIT_ARENA_DIRECT_SIZE       (XF_INIT_ARENA_CHUNK_SIZE / 4)
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef enum _xf_init_arena_kind_t {
+    XF_INIT_ARENA_RW = 0x00,
+    XF_INIT_ARENA_RO,
+
+    XF_INIT_ARENA_MAX,
+} xf_init_arena_kind_t;
+
+typedef struct _xf_init_arena_t {
+    uint8_t *base;
+    size_t size;
+    size_t used;                            /*!< 原子地增加 */
+    bool sealed;
+} xf_init_arena_t;
+
+/**
+ * @brief 每个线程当前使用的块.
+ */
+typedef struct _xf_init_arena_chunk_t {
+    uint8_t *cur;
+    uint8_t *end;
+} xf_init_arena_chunk_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void *xf_init_arena_alloc(xf_init_arena_kind_t kind, size_t size, size_t align);
+static void *xf_init_arena_bump(xf_init_arena_t *p_arena, size_t size, size_t align);
+static uint8_t *xf_init_arena_base(xf_init_arena_kind_t kind);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_arena_t s_arena[XF_INIT_ARENA_MAX] = {
+    [XF_INIT_ARENA_RW] = { .size = XF_INIT_ARENA_SIZE },
+    [XF_INIT_ARENA_RO] = { .size = XF_INIT_ARENA_RO_SIZE },
+};
+
+static __thread xf_init_arena_chunk_t tl_chunk[XF_INIT_ARENA_MAX];
+
+#if !XF_INIT_ARENA_USE_MMAP
+static uint8_t s_arena_rw_buf[XF_INIT_ARENA_SIZE] __attribute__((aligned(XF_INIT_ARENA_ALIGN)));
+static uint8_t s_arena_ro_buf[XF_INIT_ARENA_RO_SIZE] __attribute__((aligned(XF_INIT_ARENA_ALIGN)));
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+#define XF_INIT_ARENA_ALIGN_UP(x, align)    (((x) + ((align) - 1)) & ~((uintptr_t)(align) - 1))
+
+/* ==================== [Global Functions] ================================== */
+
+void *xf_init_alloc(size_t size)
+{
+    return xf_init_arena_alloc(XF_INIT_ARENA_RW, size, XF_INIT_ARENA_ALIGN);
+}
+
+void *xf_init_alloc_aligned(size_t size, size_t align)
+{
+    if ((align == 0) || (align & (align - 1))) {
+        return NULL;
+    }
+    return xf_init_arena_alloc(XF_INIT_ARENA_RW, size, (align < XF_INIT_ARENA_ALIGN) ? XF_INIT_ARENA_ALIGN : align);
+}
+
+void *xf_init_alloc_ro(size_t size)
+{
+    return xf_init_arena_alloc(XF_INIT_ARENA_RO, size, XF_INIT_ARENA_ALIGN);
+}
+
+xf_err_t xf_init_arena_seal(void)
+{
+    xf_init_arena_t *p_arena = &s_arena[XF_INIT_ARENA_RO];
+
+    if (__atomic_exchange_n(&p_arena->sealed, true, __ATOMIC_ACQ_REL)) {
+        return XF_ERR_INVALID_STATE;
+    }
+
+#if XF_INIT_ARENA_USE_MMAP
+    uint8_t *base = __atomic_load_n(&p_arena->base, __ATOMIC_ACQUIRE);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t used = XF_INIT_ARENA_ALIGN_UP(__atomic_load_n(&p_arena->used, __ATOMIC_ACQUIRE), page);
+    if ((NULL != base) && (used > 0) && (mprotect(base, used, PROT_READ) != 0)) {
+        XF_LOGE(TAG, "mprotect failed.");
+        return XF_FAIL;
+    }
+    XF_LOGD(TAG, "sealed %u bytes read-only.", (unsigned)used);
+#endif
+
+    return XF_OK;
+}
+
+void xf_init_arena_used(size_t *p_rw, size_t *p_ro)
+{
+    if (p_rw) {
+        *p_rw = __atomic_load_n(&s_arena[XF_INIT_ARENA_RW].used, __ATOMIC_RELAXED);
+    }
+    if (p_ro) {
+        *p_ro = __atomic_load_n(&s_arena[XF_INIT_ARENA_RO].used, __ATOMIC_RELAXED);
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void *xf_init_arena_alloc(xf_init_arena_kind_t kind, size_t size, size_t align)
+{
+    xf_init_arena_t *p_arena = &s_arena[kind];
+    xf_init_arena_chunk_t *p_chunk = &tl_chunk[kind];
+    uint8_t *p;
+
+    /* 先排除超过整个 arena 的请求, 之后 size + align 与 p + size 都不会溢出 */
+    if ((size == 0) || (size > p_arena->size) || (align > p_arena->size)
+            || __atomic_load_n(&p_arena->sealed, __ATOMIC_ACQUIRE)
+            || (NULL == xf_init_arena_base(kind))) {
+        return NULL;
+    }
+
+    /* 本线程的块内无锁分配 */
+    if (NULL != p_chunk->cur) {
+        p = (uint8_t *)XF_INIT_ARENA_ALIGN_UP((uintptr_t)p_chunk->cur, align);
+        if ((p <= p_chunk->end) && (size <= (size_t)(p_chunk->end - p))) {
+            p_chunk->cur = p + size;
+            return p;
+        }
+    }
+
+    if (size + align > XF_INIT_ARENA_DIRECT_SIZE) {
+        p = xf_init_arena_bump(p_arena, size, align);
+    } else {
+        /* 取新块, 旧块的剩余空间丢弃 */
+        uint8_t *chunk = xf_init_arena_bump(p_arena, XF_INIT_ARENA_CHUNK_SIZE, XF_INIT_ARENA_ALIGN);
+        if (NULL == chunk) {
+            p = xf_init_arena_bump(p_arena, size, align);
+        } else {
+            p_chunk->end = chunk + XF_INIT_ARENA_CHUNK_SIZE;
+            p = (uint8_t *)XF_INIT_ARENA_ALIGN_UP((uintptr_t)chunk, align);
+            p_chunk->cur = p + size;
+        }
+    }
+
+    if (NULL == p) {
+        XF_LOGE(TAG, "arena exhausted (%u bytes requested), increase XF_INIT_ARENA%s_SIZE.",
+                (unsigned)size, (kind == XF_INIT_ARENA_RO) ? "_RO" : "");
+    }
+    return p;
+}
+
+static void *xf_init_arena_bump(xf_init_arena_t *p_arena, size_t size, size_t align)
+{
+    size_t used = __atomic_load_n(&p_arena->used, __ATOMIC_RELAXED);
+    uintptr_t base = (uintptr_t)p_arena->base;
+    size_t start;
+
+    do {
+        /* 对齐的是地址而不是偏移, 静态缓冲区只按 XF_INIT_ARENA_ALIGN 对齐 */
+        start = (size_t)(XF_INIT_ARENA_ALIGN_UP(base + used, align) - base);
+        if ((start > p_arena->size) || (size > p_arena->size - start)) {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&p_arena->used, &used, start + size, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return p_arena->base + start;
+}
+
+/* 第一次分配时映射; 多个线程同时映射时只保留一个 */
+static uint8_t *xf_init_arena_base(xf_init_arena_kind_t kind)
+{
+    xf_init_arena_t *p_arena = &s_arena[kind];
+    uint8_t *base = __atomic_load_n(&p_arena->base, __ATOMIC_ACQUIRE);
+    uint8_t *expected = NULL;
+
+    if (NULL != base) {
+        return base;
+    }
+
+#if XF_INIT_ARENA_USE_MMAP
+    /* 多映射一个大页, 把起始地址对齐到 2MB, 以便内核使用透明大页; 长度同样按大页取整, 只占虚拟地址 */
+    size_t len = XF_INIT_ARENA_ALIGN_UP(p_arena->size, XF_INIT_ARENA_HUGE_PAGE_SIZE);
+    size_t map_size = len + XF_INIT_ARENA_HUGE_PAGE_SIZE;
+    uint8_t *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+        XF_LOGE(TAG, "mmap %u bytes failed.", (unsigned)map_size);
+        return NULL;
+    }
+    base = (uint8_t *)XF_INIT_ARENA_ALIGN_UP((uintptr_t)map, XF_INIT_ARENA_HUGE_PAGE_SIZE);
+    if (base > map) {
+        munmap(map, (size_t)(base - map));
+    }
+    if (map + map_size > base + len) {
+        munmap(base + len, (size_t)(map + map_size - (base + len)));
+    }
+#if XF_INIT_ARENA_HUGE_PAGES && defined(MADV_HUGEPAGE)
+    madvise(base, len, MADV_HUGEPAGE);
+#endif
+    if (!__atomic_compare_exchange_n(&p_arena->base, &expected, base, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        munmap(base, len);
+        base = expected;
+    }
+#else
+    base = (kind == XF_INIT_ARENA_RO) ? s_arena_ro_buf : s_arena_rw_buf;
+    if (!__atomic_compare_exchange_n(&p_arena->base, &expected, base, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        base = expected;
+    }
+#endif
+
+    return base;
+}
+
+#endif /* XF_INIT_ENABLE_ARENA */
@@ -0,0 +1,106 @@
+/**
+ * @file xf_init_arena.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化期间使用的 bump 分配器。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_ARENA_H__
+#define __XF_INIT_ARENA_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_ARENA || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_arena arena
+ * @brief 初始化函数分配的长期存在的小对象 (设备表、配置、回调表等) 从 xf_init 的 arena 中分配,
+ * 紧密排列, 不经过堆的锁. 需要开启 `XF_INIT_ENABLE_ARENA`.
+ *
+ * - 每个线程从 arena 中一次取一块 (`XF_INIT_ARENA_CHUNK_SIZE`), 之后在块内无锁顺序分配,
+ *   并发初始化时互不竞争;
+ * - POSIX 上 arena 为一次 mmap 的连续区域, 按 2MB 对齐并建议内核使用透明大页;
+ *   其他平台为静态数组;
+ * - 分配的内存不能释放, 随进程一直存在;
+ * - @ref xf_init_alloc_ro 分配读多写少的数据, @ref xf_init_arena_seal 之后变为只读
+ *   (`XF_INIT_ARENA_SEAL_AFTER_INIT` 为 1 时在所有等级执行完后自动调用).
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 从 arena 中分配, 按 `XF_INIT_ARENA_ALIGN` 对齐, 内容为 0.
+ *
+ * @param size 字节数.
+ * @return void* 内存, arena 已满时为 NULL.
+ */
+void *xf_init_alloc(size_t size);
+
+/**
+ * @brief 从 arena 中按指定对齐分配, 内容为 0.
+ *
+ * @param size 字节数.
+ * @param align 对齐, 需为 2 的幂, 如 cache line 大小.
+ * @return void* 内存, arena 已满或 align 无效时为 NULL.
+ */
+void *xf_init_alloc_aligned(size_t size, size_t align);
+
+/**
+ * @brief 从只读 arena 中分配读多写少的数据, @ref xf_init_arena_seal 之前可以写入.
+ *
+ * @param size 字节数.
+ * @return void* 内存, arena 已满或已经只读时为 NULL.
+ */
+void *xf_init_alloc_ro(size_t size);
+
+/**
+ * @brief 把只读 arena 中已分配的部分设为只读 (POSIX 上为 mprotect), 之后不能再用 @ref xf_init_alloc_ro 分配.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      已经只读
+ *      - XF_FAIL                   mprotect 失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_arena_seal(void);
+
+/**
+ * @brief 获取已使用的字节数 (含各线程已取走但未用完的块).
+ *
+ * @param[out] p_rw 可写 arena, 可为 NULL.
+ * @param[out] p_ro 只读 arena, 可为 NULL.
+ */
+void xf_init_arena_used(size_t *p_rw, size_t *p_ro);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_arena
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_ARENA */
+
+#endif /* __XF_INIT_ARENA_H__ */
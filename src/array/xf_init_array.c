@@ -0,0 +1,276 @@
+/**
+ * @file xf_init_array.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 同类实例数组（端口、通道、传感器等）的批量初始化。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_array.h"
+
+#if XF_INIT_ENABLE_ARRAY
+
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "array"
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define XF_INIT_ARRAY_USE_PTHREAD    1
+#else
+#   define XF_INIT_ARRAY_USE_PTHREAD    0
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 一次 xf_init_array_run 中所有线程共享 */
+typedef struct _xf_init_array_ctx_t {
+    xf_init_array_t *p_array;
+    size_t range_len;
+    int result;                             /*!< 第一个非 0 的返回值 */
+} xf_init_array_ctx_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void xf_init_array_link(xf_init_array_t *p_array);
+static xf_init_array_t *xf_init_array_find(const char *func_name);
+static void xf_init_array_range(xf_init_array_ctx_t *p_ctx, size_t begin, size_t end);
+static void xf_init_array_mark(xf_init_array_t *p_array, size_t index, int result);
+static void xf_init_array_result(xf_init_array_ctx_t *p_ctx, int result);
+static void *xf_init_array_worker(void *arg);
+static size_t xf_init_array_threads(size_t ranges);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_array_t *s_head = NULL;
+static xf_init_array_t *s_tail = NULL;
+
+#if XF_INIT_ARRAY_USE_PTHREAD
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+#if XF_INIT_ARRAY_USE_PTHREAD
+#   define xf_init_array_lock()         pthread_mutex_lock(&s_lock)
+#   define xf_init_array_unlock()       pthread_mutex_unlock(&s_lock)
+#else
+#   define xf_init_array_lock()
+#   define xf_init_array_unlock()
+#endif
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_init_array_run(xf_init_array_t *p_array)
+{
+    xf_init_array_ctx_t ctx = {
+        .p_array    = p_array,
+        .range_len  = p_array->range_len ? p_array->range_len : p_array->num,
+    };
+    size_t ranges;
+    size_t threads;
+
+    xf_init_array_link(p_array);
+    if (0 == p_array->num) {
+        return 0;
+    }
+
+    ranges = (p_array->num + ctx.range_len - 1) / ctx.range_len;
+    threads = (p_array->range_len != 0) ? xf_init_array_threads(ranges) : 1;
+    __atomic_store_n(&p_array->next, 0, __ATOMIC_RELAXED);
+
+#if XF_INIT_ARRAY_USE_PTHREAD
+    if (threads > 1) {
+        /* 调用线程也参与领取, 额外创建 threads - 1 个线程 */
+        pthread_t workers[XF_INIT_ARRAY_THREADS];
+        bool started[XF_INIT_ARRAY_THREADS] = { false };
+        size_t i;
+
+        for (i = 1; i < threads; i++) {
+            started[i] = (pthread_create(&workers[i], NULL, xf_init_array_worker, &ctx) == 0);
+            if (!started[i]) {
+                /* 剩余的段由已有的线程领取 */
+                XF_LOGW(TAG, "%s: failed to start worker %u.", p_array->func_name, (unsigned)i);
+            }
+        }
+        xf_init_array_worker(&ctx);
+        for (i = 1; i < threads; i++) {
+            if (started[i]) {
+                pthread_join(workers[i], NULL);
+            }
+        }
+    } else
+#endif
+    {
+        xf_init_array_worker(&ctx);
+    }
+
+    XF_LOGD(TAG, "%s: %u/%u instances done in %u ranges on %u threads.", p_array->func_name,
+            (unsigned)xf_init_array_done_count(p_array->func_name), (unsigned)p_array->num,
+            (unsigned)ranges, (unsigned)threads);
+
+    return ctx.result;
+}
+
+xf_err_t xf_init_array_state(const char *func_name, size_t index)
+{
+    xf_init_array_t *p_array = xf_init_array_find(func_name);
+    uint32_t bit;
+
+    if (NULL == p_array) {
+        return XF_ERR_NOT_FOUND;
+    }
+    if (index >= p_array->num) {
+        return XF_ERR_INVALID_ARG;
+    }
+    bit = 1u << (index & 31);
+    if (!(__atomic_load_n(&p_array->done_mask[index >> 5], __ATOMIC_ACQUIRE) & bit)) {
+        return XF_ERR_NOT_FINISHED;
+    }
+    return (__atomic_load_n(&p_array->failed_mask[index >> 5], __ATOMIC_ACQUIRE) & bit) ? XF_FAIL : XF_OK;
+}
+
+size_t xf_init_array_done_count(const char *func_name)
+{
+    xf_init_array_t *p_array = xf_init_array_find(func_name);
+    size_t count = 0;
+    size_t i;
+
+    if (NULL == p_array) {
+        return 0;
+    }
+    for (i = 0; i < XF_INIT_ARRAY_MASK_WORDS(p_array->num); i++) {
+        uint32_t ok = __atomic_load_n(&p_array->done_mask[i], __ATOMIC_ACQUIRE)
+                      & ~__atomic_load_n(&p_array->failed_mask[i], __ATOMIC_ACQUIRE);
+        count += (size_t)__builtin_popcount(ok);
+    }
+    return count;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void xf_init_array_link(xf_init_array_t *p_array)
+{
+    xf_init_array_lock();
+    if (!p_array->linked) {
+        p_array->linked = true;
+        p_array->p_next = NULL;
+        if (s_tail) {
+            s_tail->p_next = p_array;
+        } else {
+            s_head = p_array;
+        }
+        s_tail = p_array;
+    }
+    xf_init_array_unlock();
+}
+
+static xf_init_array_t *xf_init_array_find(const char *func_name)
+{
+    xf_init_array_t *p_array;
+
+    if (NULL == func_name) {
+        return NULL;
+    }
+    xf_init_array_lock();
+    for (p_array = s_head; p_array; p_array = p_array->p_next) {
+        if (strcmp(p_array->func_name, func_name) == 0) {
+            break;
+        }
+    }
+    xf_init_array_unlock();
+    return p_array;
+}
+
+static void xf_init_array_range(xf_init_array_ctx_t *p_ctx, size_t begin, size_t end)
+{
+    xf_init_array_t *p_array = p_ctx->p_array;
+    size_t i;
+    int ret;
+
+    if (p_array->batch) {
+        ret = p_array->batch(begin, end);
+        if (ret != 0) {
+            XF_LOGW(TAG, "%s: batch [%u, %u) failed [ret: %d].", p_array->func_name,
+                    (unsigned)begin, (unsigned)end, ret);
+            for (i = begin; i < end; i++) {
+                xf_init_array_mark(p_array, i, ret);
+            }
+            xf_init_array_result(p_ctx, ret);
+            return;
+        }
+    }
+    for (i = begin; i < end; i++) {
+        ret = p_array->func(i);
+        xf_init_array_mark(p_array, i, ret);
+        xf_init_array_result(p_ctx, ret);
+    }
+}
+
+/* 各线程同时完成不同的实例, 位图用原子操作更新 */
+static void xf_init_array_mark(xf_init_array_t *p_array, size_t index, int result)
+{
+    uint32_t bit = 1u << (index & 31);
+    if (result != 0) {
+        __atomic_fetch_or(&p_array->failed_mask[index >> 5], bit, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_or(&p_array->done_mask[index >> 5], bit, __ATOMIC_RELEASE);
+}
+
+static void xf_init_array_result(xf_init_array_ctx_t *p_ctx, int result)
+{
+    int expected = 0;
+    if (result != 0) {
+        __atomic_compare_exchange_n(&p_ctx->result, &expected, result, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/* 每次领取一段, 直到没有剩余的段; 段的大小相同, 先结束的线程多领 */
+static void *xf_init_array_worker(void *arg)
+{
+    xf_init_array_ctx_t *p_ctx = (xf_init_array_ctx_t *)arg;
+    xf_init_array_t *p_array = p_ctx->p_array;
+    size_t begin;
+
+    for (;;) {
+        begin = __atomic_fetch_add(&p_array->next, p_ctx->range_len, __ATOMIC_RELAXED);
+        if (begin >= p_array->num) {
+            break;
+        }
+        xf_init_array_range(p_ctx, begin,
+                            (p_array->num - begin > p_ctx->range_len) ? begin + p_ctx->range_len : p_array->num);
+    }
+    return NULL;
+}
+
+static size_t xf_init_array_threads(size_t ranges)
+{
+    size_t threads = XF_INIT_ARRAY_THREADS;
+
+#if XF_INIT_ARRAY_USE_PTHREAD && defined(_SC_NPROCESSORS_ONLN)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if ((cpus > 0) && ((size_t)cpus < threads)) {
+        threads = (size_t)cpus;
+    }
+#else
+    threads = 1;
+#endif
+    if (threads > ranges) {
+        threads = ranges;
+    }
+    return (threads > 0) ? threads : 1;
+}
+
+#endif /* XF_INIT_ENABLE_ARRAY */
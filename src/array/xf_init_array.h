@@ -0,0 +1,177 @@
+/**
+ * @file xf_init_array.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 同类实例数组（端口、通道、传感器等）的批量初始化。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_ARRAY_H__
+#define __XF_INIT_ARRAY_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_ARRAY || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_array array
+ * @brief 几十个相同的实例不需要各写一个包装函数、各占一个描述符, 整个数组只导出一次,
+ * 由 xf_init 按下标逐个调用 `function(index)`. 需要开启 `XF_INIT_ENABLE_ARRAY`.
+ *
+ * - @ref XF_INIT_EXPORT_ARRAY: 在当前线程上按下标顺序执行;
+ * - @ref XF_INIT_EXPORT_ARRAY_EX: 数组按 range 个实例分段, 每段先调用一次 `batch(begin, end)`
+ *   (共享总线事务、批量配置寄存器等), 成功后再对段内每个实例调用 `function(index)`;
+ *   range 不为 0 时各段由最多 `XF_INIT_ARRAY_THREADS` 个线程并发领取执行.
+ *
+ * 一个实例失败不影响其他实例; 段的 batch 失败时该段所有实例视为失败, 不再逐个调用.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * @brief 记录 count 个实例的执行结果所需的 32 位字数.
+ */
+#define XF_INIT_ARRAY_MASK_WORDS(count)     (((count) + 31) / 32)
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 对一个实例执行的初始化函数.
+ *
+ * @param index 实例下标, 0 ~ count - 1.
+ * @return int 0 表示成功.
+ */
+typedef int (*xf_init_array_fn_t)(size_t index);
+
+/**
+ * @brief 对一段实例执行一次的批量初始化函数.
+ *
+ * @param begin 第一个实例的下标.
+ * @param end 最后一个实例的下标 + 1.
+ * @return int 0 表示成功.
+ */
+typedef int (*xf_init_array_batch_fn_t)(size_t begin, size_t end);
+
+/**
+ * @brief （内部使用）由 @ref XF_INIT_EXPORT_ARRAY / @ref XF_INIT_EXPORT_ARRAY_EX 静态定义.
+ */
+typedef struct _xf_init_array_t {
+    xf_init_array_fn_t func;                /*!< 每个实例的初始化函数 */
+    xf_init_array_batch_fn_t batch;         /*!< 每段的批量初始化函数, 可为 NULL */
+    const char *func_name;                  /*!< 函数名 */
+    size_t num;                             /*!< 实例个数 */
+    size_t range_len;                       /*!< 每段实例个数, 0 表示整个数组为一段且串行执行 */
+    uint32_t *done_mask;                    /*!< 已执行的实例, XF_INIT_ARRAY_MASK_WORDS(num) 个字 */
+    uint32_t *failed_mask;                  /*!< 失败的实例 */
+
+    /* 以下由 array 模块维护 */
+    size_t next;                            /*!< 下一段的起始下标 */
+    bool linked;                            /*!< 已加入链表 */
+    struct _xf_init_array_t *p_next;
+} xf_init_array_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 查询数组初始化函数在某个实例上的执行结果.
+ *
+ * @param func_name 函数名.
+ * @param index 实例下标.
+ * @return xf_err_t
+ *      - XF_ERR_NOT_FOUND          函数不存在或所属等级尚未执行
+ *      - XF_ERR_INVALID_ARG        下标超出实例个数
+ *      - XF_ERR_NOT_FINISHED       该实例尚未执行
+ *      - XF_FAIL                   返回了非 0
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_array_state(const char *func_name, size_t index);
+
+/**
+ * @brief 获取执行成功的实例个数.
+ *
+ * @param func_name 函数名.
+ * @return size_t 个数, 函数不存在时为 0.
+ */
+size_t xf_init_array_done_count(const char *func_name);
+
+/**
+ * @brief （内部函数）对所有实例执行. 由 @ref XF_INIT_EXPORT_ARRAY_EX 生成的函数调用.
+ *
+ * @param p_array 数组初始化函数.
+ * @return int 第一个非 0 的返回值, 全部成功时为 0.
+ */
+int xf_init_array_run(xf_init_array_t *p_array);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * @brief 导出数组初始化函数, 类型为 @ref xf_init_array_fn_t, 按下标顺序对每个实例执行.
+ *
+ * 实际注册的函数名为 `function_array`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_array)`.
+ *
+ * @param function 每个实例的初始化函数.
+ * @param count 实例个数, 需为常量表达式.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_ARRAY(function, count, level) \
+    XF_INIT_EXPORT_ARRAY_EX(function, NULL, count, 0, level)
+
+/**
+ * @brief 导出分段执行的数组初始化函数.
+ *
+ * 实际注册的函数名为 `function_array`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_array)`.
+ *
+ * @param function 每个实例的初始化函数, 类型为 @ref xf_init_array_fn_t.
+ * @param batch_fn 每段的批量初始化函数, 类型为 @ref xf_init_array_batch_fn_t, 可为 NULL.
+ * @param count 实例个数, 需为常量表达式.
+ * @param range 每段实例个数, 0 表示整个数组为一段且在当前线程上执行;
+ *              不为 0 时各段并发执行, function 与 batch_fn 需可重入.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_ARRAY_EX(function, batch_fn, count, range, level) \
+    static uint32_t __xf_init_array_done_##function[XF_INIT_ARRAY_MASK_WORDS(count)]; \
+    static uint32_t __xf_init_array_failed_##function[XF_INIT_ARRAY_MASK_WORDS(count)]; \
+    static xf_init_array_t __xf_init_array_##function = { \
+        .func           = (function), \
+        .batch          = (batch_fn), \
+        .func_name      = #function, \
+        .num            = (count), \
+        .range_len      = (range), \
+        .done_mask      = __xf_init_array_done_##function, \
+        .failed_mask    = __xf_init_array_failed_##function, \
+    }; \
+    static int function##_array(void) \
+    { \
+        return xf_init_array_run(&__xf_init_array_##function); \
+    } \
+    XF_INIT_EXPORT_##level(function##_array)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_array
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_ARRAY */
+
+#endif /* __XF_INIT_ARRAY_H__ */
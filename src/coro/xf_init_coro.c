@@ -0,0 +1,447 @@
+/**
+ * @file xf_init_coro.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 协程初始化函数使用的事件循环（定时器、fd 就绪、等待其他初始化完成）。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_coro.h"
+
+#if XF_INIT_ENABLE_CORO
+
+#include <string.h>
+
+#if defined(__linux__)
+#   include <sys/epoll.h>
+#   include <unistd.h>
+#   include <errno.h>
+#   define XF_INIT_CORO_USE_EPOLL   1
+#   define XF_INIT_CORO_USE_POLL    0
+#elif defined(__unix__) || defined(__APPLE__)
+#   include <poll.h>
+#   define XF_INIT_CORO_USE_EPOLL   0
+#   define XF_INIT_CORO_USE_POLL    1
+#else
+#   define XF_INIT_CORO_USE_EPOLL   0
+#   define XF_INIT_CORO_USE_POLL    0
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "coro"
+
+#define XF_INIT_CORO_NEVER      UINT64_MAX
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef enum _xf_init_coro_kind_t {
+    XF_INIT_CORO_WAIT_FD = 0x00,
+    XF_INIT_CORO_WAIT_TIMER,
+    XF_INIT_CORO_WAIT_DONE,
+} xf_init_coro_kind_t;
+
+/**
+ * @brief 单向链表, 尾部追加, 头部取出.
+ */
+typedef struct _xf_init_coro_queue_t {
+    xf_init_coro_wait_t *p_head;
+    xf_init_coro_wait_t *p_tail;
+} xf_init_coro_queue_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static bool xf_init_coro_blocking(uint8_t level);
+static void xf_init_coro_step(void);
+static void xf_init_coro_push(xf_init_coro_queue_t *p_queue, xf_init_coro_wait_t *p_wait);
+static xf_init_coro_wait_t *xf_init_coro_pop(xf_init_coro_queue_t *p_queue);
+static void xf_init_coro_expire(uint64_t now_us);
+static void xf_init_coro_fail_orphans(void);
+static void xf_init_coro_abandon(void);
+static xf_init_coro_t *xf_init_coro_find(const char *func_name);
+static bool xf_init_coro_poll_fds(uint64_t timeout_us);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_coro_t *s_head = NULL;
+static size_t s_pending = 0;
+
+static xf_init_coro_queue_t s_ready = { 0 };                /*!< 等待已结束, 待调用 cb */
+static xf_init_coro_wait_t *s_timers = NULL;                /*!< 按到期时间排序 */
+static xf_init_coro_queue_t s_done_waits = { 0 };           /*!< 等待其他协程结束 */
+static size_t s_fd_waits = 0;
+
+#if XF_INIT_CORO_USE_EPOLL
+static int s_epfd = -1;
+#elif XF_INIT_CORO_USE_POLL
+static xf_init_coro_queue_t s_fds = { 0 };
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_init_coro_status(const char *func_name, int *p_result)
+{
+    xf_init_coro_t *p_coro = xf_init_coro_find(func_name);
+
+    if (NULL == p_coro) {
+        return XF_ERR_NOT_FOUND;
+    }
+    if (p_coro->state != XF_INIT_CORO_STATE_DONE) {
+        return XF_ERR_NOT_FINISHED;
+    }
+    if (p_result) {
+        *p_result = p_coro->result;
+    }
+    return XF_OK;
+}
+
+size_t xf_init_coro_pending(void)
+{
+    return s_pending;
+}
+
+void xf_init_coro_run(void)
+{
+    while (s_pending > 0) {
+        xf_init_coro_step();
+    }
+}
+
+void xf_init_coro_begin(xf_init_coro_t *p_coro)
+{
+    if (p_coro->state == XF_INIT_CORO_STATE_IDLE) {
+        p_coro->p_next = s_head;
+        s_head = p_coro;
+    }
+    if (p_coro->state != XF_INIT_CORO_STATE_RUNNING) {
+        p_coro->state = XF_INIT_CORO_STATE_RUNNING;
+        p_coro->start_us = xf_init_dispatch_time_us();
+        s_pending++;
+    }
+}
+
+void xf_init_coro_finish(xf_init_coro_t *p_coro, int result)
+{
+    xf_init_coro_queue_t waits = s_done_waits;
+    xf_init_coro_wait_t *p_wait;
+
+    if (p_coro->state != XF_INIT_CORO_STATE_RUNNING) {
+        return;
+    }
+    p_coro->result = result;
+    p_coro->state = XF_INIT_CORO_STATE_DONE;
+    s_pending--;
+
+    if (result != 0) {
+        XF_LOGE(TAG, "%s failed: %d", p_coro->func_name, result);
+    } else {
+        XF_LOGD(TAG, "%s done in %u us.", p_coro->func_name,
+                (unsigned)(xf_init_dispatch_time_us() - p_coro->start_us));
+    }
+
+    /* 等待它的协程在事件循环中恢复, 不在这里嵌套恢复 */
+    s_done_waits = (xf_init_coro_queue_t) { 0 };
+    while ((p_wait = xf_init_coro_pop(&waits)) != NULL) {
+        if (strcmp(p_wait->func_name, p_coro->func_name) == 0) {
+            p_wait->result = result;
+            xf_init_coro_push(&s_ready, p_wait);
+        } else {
+            xf_init_coro_push(&s_done_waits, p_wait);
+        }
+    }
+}
+
+xf_err_t xf_init_coro_wait_fd(xf_init_coro_wait_t *p_wait, int fd, uint32_t events)
+{
+    p_wait->kind = XF_INIT_CORO_WAIT_FD;
+    p_wait->fd = fd;
+    p_wait->events = events;
+    p_wait->result = 0;
+
+#if XF_INIT_CORO_USE_EPOLL
+    struct epoll_event ev = {
+        .events = ((events & XF_INIT_CORO_READ) ? EPOLLIN : 0)
+        | ((events & XF_INIT_CORO_WRITE) ? EPOLLOUT : 0) | EPOLLONESHOT,
+        .data.ptr = p_wait,
+    };
+    if (s_epfd < 0) {
+        s_epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (s_epfd < 0) {
+            XF_LOGE(TAG, "epoll_create1 failed: %d", errno);
+            return XF_FAIL;
+        }
+    }
+    if (epoll_ctl(s_epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        XF_LOGE(TAG, "epoll_ctl(%d) failed: %d", fd, errno);
+        return XF_FAIL;
+    }
+    s_fd_waits++;
+    return XF_OK;
+#elif XF_INIT_CORO_USE_POLL
+    xf_init_coro_push(&s_fds, p_wait);
+    s_fd_waits++;
+    return XF_OK;
+#else
+    return XF_ERR_NOT_SUPPORTED;
+#endif
+}
+
+xf_err_t xf_init_coro_wait_timer(xf_init_coro_wait_t *p_wait, uint32_t ms)
+{
+    xf_init_coro_wait_t **pp = &s_timers;
+
+    p_wait->kind = XF_INIT_CORO_WAIT_TIMER;
+    p_wait->due_us = xf_init_dispatch_time_us() + (uint64_t)ms * 1000u;
+    p_wait->result = 0;
+
+    /* 同一时刻到期的按加入顺序 */
+    while ((*pp != NULL) && ((*pp)->due_us <= p_wait->due_us)) {
+        pp = &(*pp)->p_next;
+    }
+    p_wait->p_next = *pp;
+    *pp = p_wait;
+    return XF_OK;
+}
+
+xf_err_t xf_init_coro_wait_done(xf_init_coro_wait_t *p_wait, const char *func_name)
+{
+    xf_init_coro_t *p_coro = xf_init_coro_find(func_name);
+
+    p_wait->kind = XF_INIT_CORO_WAIT_DONE;
+    p_wait->func_name = func_name;
+    if ((NULL != p_coro) && (p_coro->state == XF_INIT_CORO_STATE_DONE)) {
+        p_wait->result = p_coro->result;
+        return XF_ERR_INVALID_STATE;
+    }
+    p_wait->result = XF_ERR_NOT_FOUND;
+    xf_init_coro_push(&s_done_waits, p_wait);
+    return XF_OK;
+}
+
+void xf_init_coro_barrier(uint8_t level)
+{
+    while (xf_init_coro_blocking(level)) {
+        xf_init_coro_step();
+    }
+}
+
+void xf_init_coro_atfork_child(void)
+{
+#if XF_INIT_CORO_USE_EPOLL
+    if (s_epfd >= 0) {
+        close(s_epfd);
+        s_epfd = -1;
+    }
+#elif XF_INIT_CORO_USE_POLL
+    s_fds = (xf_init_coro_queue_t) { 0 };
+#endif
+    s_ready = (xf_init_coro_queue_t) { 0 };
+    s_done_waits = (xf_init_coro_queue_t) { 0 };
+    s_timers = NULL;
+    s_fd_waits = 0;
+    xf_init_coro_abandon();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static bool xf_init_coro_blocking(uint8_t level)
+{
+    xf_init_coro_t *p_coro;
+
+    for (p_coro = s_head; p_coro; p_coro = p_coro->p_next) {
+        if ((p_coro->state == XF_INIT_CORO_STATE_RUNNING) && (p_coro->level_num <= level)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 事件循环的一轮: 恢复已就绪的协程, 没有时等待定时器或 fd */
+static void xf_init_coro_step(void)
+{
+    xf_init_coro_wait_t *p_wait;
+    uint64_t now_us;
+    uint64_t timeout_us = XF_INIT_CORO_NEVER;
+
+    if (NULL != s_ready.p_head) {
+        /* cb 中恢复的协程可能再次等待或结束, 取出后不再访问 p_wait */
+        while ((p_wait = xf_init_coro_pop(&s_ready)) != NULL) {
+            p_wait->cb(p_wait->arg);
+        }
+        return;
+    }
+
+    if ((NULL == s_timers) && (s_fd_waits == 0)) {
+        xf_init_coro_fail_orphans();
+        return;
+    }
+
+    now_us = xf_init_dispatch_time_us();
+    if (NULL != s_timers) {
+        timeout_us = (s_timers->due_us > now_us) ? (s_timers->due_us - now_us) : 0;
+    }
+    if (!xf_init_coro_poll_fds(timeout_us) && (timeout_us > 0)) {
+        /* 没有 fd 可等待的平台上忙等定时器 */
+        return;
+    }
+    xf_init_coro_expire(xf_init_dispatch_time_us());
+}
+
+static void xf_init_coro_push(xf_init_coro_queue_t *p_queue, xf_init_coro_wait_t *p_wait)
+{
+    p_wait->p_next = NULL;
+    if (p_queue->p_tail) {
+        p_queue->p_tail->p_next = p_wait;
+    } else {
+        p_queue->p_head = p_wait;
+    }
+    p_queue->p_tail = p_wait;
+}
+
+static xf_init_coro_wait_t *xf_init_coro_pop(xf_init_coro_queue_t *p_queue)
+{
+    xf_init_coro_wait_t *p_wait = p_queue->p_head;
+
+    if (p_wait) {
+        p_queue->p_head = p_wait->p_next;
+        if (NULL == p_queue->p_head) {
+            p_queue->p_tail = NULL;
+        }
+    }
+    return p_wait;
+}
+
+static void xf_init_coro_expire(uint64_t now_us)
+{
+    while ((NULL != s_timers) && (s_timers->due_us <= now_us)) {
+        xf_init_coro_wait_t *p_wait = s_timers;
+        s_timers = p_wait->p_next;
+        xf_init_coro_push(&s_ready, p_wait);
+    }
+}
+
+/* 没有定时器与 fd 可等待, 只剩等待其他协程: 它们不会再开始, 以 XF_ERR_NOT_FOUND 结束等待 */
+static void xf_init_coro_fail_orphans(void)
+{
+    xf_init_coro_wait_t *p_wait;
+
+    if (NULL == s_done_waits.p_head) {
+        /* 协程挂起在不属于本事件循环的 awaiter 上, 无法继续 */
+        XF_LOGE(TAG, "%u coroutines can never resume.", (unsigned)s_pending);
+        xf_init_coro_abandon();
+        return;
+    }
+    while ((p_wait = xf_init_coro_pop(&s_done_waits)) != NULL) {
+        XF_LOGW(TAG, "awaited init %s never started in this level.", p_wait->func_name);
+        p_wait->result = XF_ERR_NOT_FOUND;
+        xf_init_coro_push(&s_ready, p_wait);
+    }
+}
+
+/* 尚未结束的协程不会再恢复, 以 XF_ERR_INVALID_STATE 结束, 协程帧不再释放 */
+static void xf_init_coro_abandon(void)
+{
+    xf_init_coro_t *p_coro;
+
+    for (p_coro = s_head; p_coro; p_coro = p_coro->p_next) {
+        if (p_coro->state == XF_INIT_CORO_STATE_RUNNING) {
+            p_coro->state = XF_INIT_CORO_STATE_DONE;
+            p_coro->result = XF_ERR_INVALID_STATE;
+        }
+    }
+    s_pending = 0;
+}
+
+static xf_init_coro_t *xf_init_coro_find(const char *func_name)
+{
+    xf_init_coro_t *p_coro;
+
+    if (NULL == func_name) {
+        return NULL;
+    }
+    for (p_coro = s_head; p_coro; p_coro = p_coro->p_next) {
+        if (strcmp(p_coro->func_name, func_name) == 0) {
+            break;
+        }
+    }
+    return p_coro;
+}
+
+/* 等待 fd 就绪, 最多 timeout_us; 就绪的等待移入 s_ready. 返回 false 表示平台不支持等待 */
+static bool xf_init_coro_poll_fds(uint64_t timeout_us)
+{
+    int timeout_ms = -1;
+
+    if (timeout_us != XF_INIT_CORO_NEVER) {
+        timeout_ms = (timeout_us / 1000u >= INT32_MAX) ? INT32_MAX : (int)((timeout_us + 999u) / 1000u);
+    }
+
+#if XF_INIT_CORO_USE_EPOLL
+    struct epoll_event evs[XF_INIT_CORO_MAX_EVENTS];
+    int n;
+
+    if (s_epfd < 0) {
+        s_epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (s_epfd < 0) {
+            return false;
+        }
+    }
+    n = epoll_wait(s_epfd, evs, XF_INIT_CORO_MAX_EVENTS, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        xf_init_coro_wait_t *p_wait = (xf_init_coro_wait_t *)evs[i].data.ptr;
+        epoll_ctl(s_epfd, EPOLL_CTL_DEL, p_wait->fd, NULL);
+        p_wait->result = ((evs[i].events & EPOLLIN) ? XF_INIT_CORO_READ : 0)
+                         | ((evs[i].events & EPOLLOUT) ? XF_INIT_CORO_WRITE : 0)
+                         | ((evs[i].events & (EPOLLERR | EPOLLHUP)) ? XF_INIT_CORO_ERROR : 0);
+        s_fd_waits--;
+        xf_init_coro_push(&s_ready, p_wait);
+    }
+    return true;
+#elif XF_INIT_CORO_USE_POLL
+    struct pollfd fds[XF_INIT_CORO_MAX_EVENTS];
+    xf_init_coro_wait_t *waits[XF_INIT_CORO_MAX_EVENTS];
+    xf_init_coro_queue_t rest = { 0 };
+    xf_init_coro_wait_t *p_wait;
+    nfds_t n = 0;
+
+    /* 一次最多监听 XF_INIT_CORO_MAX_EVENTS 个, 其余的下一轮 */
+    for (p_wait = s_fds.p_head; p_wait && (n < XF_INIT_CORO_MAX_EVENTS); p_wait = p_wait->p_next) {
+        fds[n] = (struct pollfd) {
+            .fd     = p_wait->fd,
+            .events = (short)(((p_wait->events & XF_INIT_CORO_READ) ? POLLIN : 0)
+                              | ((p_wait->events & XF_INIT_CORO_WRITE) ? POLLOUT : 0)),
+        };
+        waits[n++] = p_wait;
+    }
+    if (poll(fds, n, timeout_ms) <= 0) {
+        return true;
+    }
+    for (nfds_t i = 0; i < n; i++) {
+        waits[i]->result = ((fds[i].revents & POLLIN) ? XF_INIT_CORO_READ : 0)
+                           | ((fds[i].revents & POLLOUT) ? XF_INIT_CORO_WRITE : 0)
+                           | ((fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) ? XF_INIT_CORO_ERROR : 0);
+    }
+    while ((p_wait = xf_init_coro_pop(&s_fds)) != NULL) {
+        if (p_wait->result != 0) {
+            s_fd_waits--;
+            xf_init_coro_push(&s_ready, p_wait);
+        } else {
+            xf_init_coro_push(&rest, p_wait);
+        }
+    }
+    s_fds = rest;
+    return true;
+#else
+    UNUSED(timeout_ms);
+    return false;
+#endif
+}
+
+#endif /* XF_INIT_ENABLE_CORO */
@@ -0,0 +1,204 @@
+/**
+ * @file xf_init_coro.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 协程初始化函数使用的事件循环（定时器、fd 就绪、等待其他初始化完成）。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_CORO_H__
+#define __XF_INIT_CORO_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_CORO || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_coro coro
+ * @brief 以 I/O 等待为主的初始化函数写成 C++20 协程 (见 xf_init.hpp 中的 `xf::init::task`),
+ * 由 xf_init 在一个事件循环中推进, 不需要每个函数一个线程. 需要开启 `XF_INIT_ENABLE_CORO`.
+ *
+ * - 协程在所属等级内按原顺序开始执行, 到第一次挂起为止, 之后同一等级的其他函数继续执行;
+ * - 下一等级开始前, 在调用 xf_init 的线程上运行事件循环, 直到本等级及以下的协程全部结束;
+ * - 事件循环在 Linux 上使用 epoll, 其他 POSIX 平台使用 poll, 其他平台只支持定时器与等待其他协程.
+ *
+ * 本文件为协程与事件循环之间的接口, 一般不直接使用.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define XF_INIT_CORO_READ           0x01    /*!< 可读 */
+#define XF_INIT_CORO_WRITE          0x02    /*!< 可写 */
+#define XF_INIT_CORO_ERROR          0x04    /*!< 出错或对端关闭 */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 等待结束时在事件循环中调用, 通常为恢复协程.
+ *
+ * @param arg @ref xf_init_coro_wait_t 的 arg.
+ */
+typedef void (*xf_init_coro_cb_t)(void *arg);
+
+/**
+ * @brief 协程初始化函数的状态.
+ */
+typedef enum _xf_init_coro_state_t {
+    XF_INIT_CORO_STATE_IDLE = 0x00,         /*!< 尚未开始 */
+    XF_INIT_CORO_STATE_RUNNING,             /*!< 已开始, 尚未结束 */
+    XF_INIT_CORO_STATE_DONE,                /*!< 已结束 */
+} xf_init_coro_state_t;
+
+/**
+ * @brief （内部使用）一个协程初始化函数, 由 xf::init::exporter 静态定义.
+ */
+typedef struct _xf_init_coro_t {
+    const char *func_name;                  /*!< 函数名 */
+    uint8_t level_num;                      /*!< 等级, 见 XF_INIT_LEVEL_* */
+
+    /* 以下由 coro 模块维护 */
+    uint8_t state;                          /*!< 见 @ref xf_init_coro_state_t */
+    int result;                             /*!< co_return 的值 */
+    uint64_t start_us;                      /*!< 开始时间 */
+    struct _xf_init_coro_t *p_next;
+} xf_init_coro_t;
+
+/**
+ * @brief （内部使用）一次等待, 位于协程帧内 (awaiter 中), 不需要动态分配.
+ */
+typedef struct _xf_init_coro_wait_t {
+    xf_init_coro_cb_t cb;                   /*!< 等待结束时调用 */
+    void *arg;                              /*!< 传给 cb */
+    int result;                             /*!< fd: XF_INIT_CORO_READ 等事件; done: 返回值; 定时器: 0 */
+
+    /* 以下由 coro 模块维护 */
+    uint8_t kind;
+    int fd;
+    uint32_t events;
+    uint64_t due_us;
+    const char *func_name;
+    struct _xf_init_coro_wait_t *p_next;
+} xf_init_coro_wait_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 查询协程初始化函数的结果.
+ *
+ * @param func_name 函数名.
+ * @param[out] p_result co_return 的值, 可为 NULL.
+ * @return xf_err_t
+ *      - XF_ERR_NOT_FOUND          不存在或尚未开始
+ *      - XF_ERR_NOT_FINISHED       尚未结束
+ *      - XF_OK                     已结束
+ */
+xf_err_t xf_init_coro_status(const char *func_name, int *p_result);
+
+/**
+ * @brief 获取已开始但尚未结束的协程个数.
+ *
+ * @return size_t 个数.
+ */
+size_t xf_init_coro_pending(void);
+
+/**
+ * @brief 运行事件循环, 直到所有已开始的协程结束.
+ *
+ * 所有等级执行完后仍未结束的协程 (如最高等级中的协程) 不会阻塞 xf_init 返回之前的流程,
+ * 需要时由应用调用.
+ */
+void xf_init_coro_run(void);
+
+/**
+ * @brief （内部函数）协程开始前调用, 登记为进行中.
+ *
+ * @param p_coro 协程初始化函数.
+ */
+void xf_init_coro_begin(xf_init_coro_t *p_coro);
+
+/**
+ * @brief （内部函数）协程结束 (co_return) 时调用, 唤醒等待它的协程.
+ *
+ * @param p_coro 协程初始化函数.
+ * @param result co_return 的值.
+ */
+void xf_init_coro_finish(xf_init_coro_t *p_coro, int result);
+
+/**
+ * @brief （内部函数）等待 fd 可读 / 可写. 同一个 fd 同一时间只能有一个等待.
+ *
+ * @param p_wait 等待, cb 与 arg 需已填写.
+ * @param fd 文件描述符.
+ * @param events XF_INIT_CORO_READ / XF_INIT_CORO_WRITE.
+ * @return xf_err_t
+ *      - XF_ERR_NOT_SUPPORTED      平台不支持
+ *      - XF_FAIL                   无法监听该 fd
+ *      - XF_OK                     已开始等待
+ */
+xf_err_t xf_init_coro_wait_fd(xf_init_coro_wait_t *p_wait, int fd, uint32_t events);
+
+/**
+ * @brief （内部函数）等待一段时间.
+ *
+ * @param p_wait 等待, cb 与 arg 需已填写.
+ * @param ms 毫秒.
+ * @return xf_err_t
+ *      - XF_OK                     已开始等待
+ */
+xf_err_t xf_init_coro_wait_timer(xf_init_coro_wait_t *p_wait, uint32_t ms);
+
+/**
+ * @brief （内部函数）等待另一个协程初始化函数结束.
+ *
+ * 等待的函数不存在, 或位于更高的等级 (永远不会在本等级结束前开始) 时,
+ * 事件循环无事可做后以 XF_ERR_NOT_FOUND 结束等待.
+ *
+ * @param p_wait 等待, cb 与 arg 需已填写.
+ * @param func_name 函数名.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      已经结束, 返回值已写入 p_wait->result, 不需要等待
+ *      - XF_OK                     已开始等待
+ */
+xf_err_t xf_init_coro_wait_done(xf_init_coro_wait_t *p_wait, const char *func_name);
+
+/**
+ * @brief （内部函数）即将执行 level 之后的等级, 运行事件循环直到 level 及以下的协程结束.
+ *
+ * @param level 已执行完的等级.
+ */
+void xf_init_coro_barrier(uint8_t level);
+
+/**
+ * @brief （内部函数）fork 之后在子进程中调用, 重建事件循环. 父进程中尚未结束的协程在子进程中不再恢复.
+ */
+void xf_init_coro_atfork_child(void);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_coro
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_CORO */
+
+#endif /* __XF_INIT_CORO_H__ */
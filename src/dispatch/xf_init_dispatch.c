@@ -0,0 +1,349 @@
+/**
+ * @file xf_init_dispatch.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 各实现方式共用的调用逻辑（计时、统计、并发执行）。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_dispatch.h"
+#include "../stats/xf_init_stats.h"
+#include "../retry/xf_init_retry.h"
+#include "../coro/xf_init_coro.h"
+#include "../warmup/xf_init_warmup.h"
+#include "../resource/xf_init_resource.h"
+#include "../percpu/xf_init_percpu.h"
+
+#if !defined(XF_INIT_GET_TIME_US) && (defined(__unix__) || defined(__APPLE__))
+#   include <time.h>
+#endif
+
+#if XF_INIT_USE_PARALLEL
+#   include <pthread.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "xf_init"
+
+/* ==================== [Typedefs] ========================================== */
+
+#if XF_INIT_USE_PARALLEL
+typedef struct _xf_init_dispatch_pool_t {
+    pthread_mutex_t submit_lock;            /*!< 同一时间只允许一批任务 */
+    pthread_mutex_t lock;
+    pthread_cond_t cond_work;
+    pthread_cond_t cond_done;
+    xf_init_dispatch_job_t *p_jobs;
+    size_t count;
+    size_t next;
+    size_t done;
+    bool started;
+} xf_init_dispatch_pool_t;
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void xf_init_dispatch_run_job(xf_init_dispatch_job_t *p_job);
+
+#if XF_INIT_USE_PARALLEL
+static void xf_init_dispatch_pool_start(void);
+static xf_init_dispatch_job_t *xf_init_dispatch_pool_take(void);
+static void xf_init_dispatch_pool_finish(xf_init_dispatch_job_t *p_job);
+static void *xf_init_dispatch_worker(void *arg);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static const char *const s_stage_verb[XF_INIT_STAGE_MAX] = {
+    [XF_INIT_STAGE_INIT]        = "initialize",
+    [XF_INIT_STAGE_SUSPEND]     = "suspend",
+    [XF_INIT_STAGE_RESUME]      = "resume",
+    [XF_INIT_STAGE_POSTFORK]    = "postfork",
+    [XF_INIT_STAGE_WARMUP]      = "warm up",
+};
+
+#if XF_INIT_USE_PARALLEL
+static xf_init_dispatch_pool_t s_pool = {
+    .submit_lock    = PTHREAD_MUTEX_INITIALIZER,
+    .lock           = PTHREAD_MUTEX_INITIALIZER,
+    .cond_work      = PTHREAD_COND_INITIALIZER,
+    .cond_done      = PTHREAD_COND_INITIALIZER,
+};
+
+/* 线程池的工作线程, 调用 xf_init 的线程虽然也领取任务, 但不算 */
+static __thread bool tl_worker = false;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_init_dispatch_call(xf_init_stage_t stage, uint8_t level, int (*func)(void), const char *func_name)
+{
+    int result = 0;
+#if XF_INIT_ENABLE_STATS
+    xf_init_stat_t stat = {
+        .func_name  = func_name,
+        .stage      = (uint8_t)stage,
+        .level      = level,
+    };
+#if XF_INIT_ENABLE_PERF_COUNTERS
+    xf_init_perf_sample_t perf_begin;
+    xf_init_perf_read(&perf_begin);
+#endif
+    stat.start_us = xf_init_dispatch_time_us();
+#endif
+
+    result = func();
+
+#if XF_INIT_ENABLE_STATS
+    stat.time_us = (uint32_t)(xf_init_dispatch_time_us() - stat.start_us);
+#if XF_INIT_ENABLE_PERF_COUNTERS
+    xf_init_perf_read(&stat.perf);
+    xf_init_perf_delta(&perf_begin, &stat.perf);
+#endif
+    stat.result = result;
+    xf_init_stats_record(&stat);
+#endif
+    UNUSED(level);
+    XF_LOGD(TAG, "%s [ret: %d] %s done.", s_stage_verb[stage], result, func_name);
+    return result;
+}
+
+int xf_init_dispatch_parallel(xf_init_dispatch_job_t *p_jobs, size_t count)
+{
+    size_t i;
+    int result = 0;
+    int deferred = 0;
+
+#if XF_INIT_USE_PARALLEL
+    if (count > 1) {
+        for (i = 0; i < count; i++) {
+            p_jobs[i].taken = false;
+        }
+        pthread_mutex_lock(&s_pool.submit_lock);
+        xf_init_dispatch_pool_start();
+        pthread_mutex_lock(&s_pool.lock);
+        s_pool.p_jobs   = p_jobs;
+        s_pool.count    = count;
+        s_pool.next     = 0;
+        s_pool.done     = 0;
+        pthread_cond_broadcast(&s_pool.cond_work);
+        /* 调用线程同样参与执行; 剩余的任务都在等资源时等待其他任务结束 */
+        while (s_pool.done < s_pool.count) {
+            xf_init_dispatch_job_t *p_job = xf_init_dispatch_pool_take();
+            if (NULL == p_job) {
+                pthread_cond_wait(&s_pool.cond_done, &s_pool.lock);
+                continue;
+            }
+            pthread_mutex_unlock(&s_pool.lock);
+            xf_init_dispatch_run_job(p_job);
+            pthread_mutex_lock(&s_pool.lock);
+            xf_init_dispatch_pool_finish(p_job);
+        }
+        s_pool.p_jobs   = NULL;
+        s_pool.count    = 0;
+        s_pool.next     = 0;
+        pthread_mutex_unlock(&s_pool.lock);
+        pthread_mutex_unlock(&s_pool.submit_lock);
+#if XF_INIT_ENABLE_PER_CPU
+        /* 工作线程领到的 per thread 函数只登记不执行, 在这里补到调用线程上 */
+        deferred = xf_init_per_thread_attach();
+#endif
+    } else
+#endif
+    {
+        for (i = 0; i < count; i++) {
+            xf_init_dispatch_run_job(&p_jobs[i]);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (p_jobs[i].result != 0) {
+            result = p_jobs[i].result;
+            break;
+        }
+    }
+    return (result != 0) ? result : deferred;
+}
+
+void xf_init_dispatch_level_done(uint8_t level)
+{
+#if XF_INIT_ENABLE_CORO
+    xf_init_coro_barrier(level);
+#endif
+#if XF_INIT_ENABLE_RETRY
+    xf_init_retry_barrier(level);
+#endif
+    UNUSED(level);
+}
+
+void xf_init_dispatch_atfork_child(void)
+{
+#if XF_INIT_ENABLE_CORO
+    xf_init_coro_atfork_child();
+#endif
+#if XF_INIT_ENABLE_WARMUP
+    xf_init_warmup_atfork_child();
+#endif
+#if XF_INIT_ENABLE_RETRY
+    xf_init_retry_atfork_child();
+#endif
+#if XF_INIT_ENABLE_PERF_COUNTERS
+    xf_init_perf_atfork_child();
+#endif
+#if XF_INIT_USE_PARALLEL
+    s_pool = (xf_init_dispatch_pool_t) {
+        .submit_lock    = PTHREAD_MUTEX_INITIALIZER,
+        .lock           = PTHREAD_MUTEX_INITIALIZER,
+        .cond_work      = PTHREAD_COND_INITIALIZER,
+        .cond_done      = PTHREAD_COND_INITIALIZER,
+    };
+#endif
+}
+
+void xf_init_dispatch_lock(void)
+{
+#if XF_INIT_USE_PARALLEL
+    pthread_mutex_lock(&s_pool.lock);
+#endif
+}
+
+void xf_init_dispatch_unlock(void)
+{
+#if XF_INIT_USE_PARALLEL
+    pthread_mutex_unlock(&s_pool.lock);
+#endif
+}
+
+bool xf_init_dispatch_in_worker(void)
+{
+#if XF_INIT_USE_PARALLEL
+    return tl_worker;
+#else
+    return false;
+#endif
+}
+
+uint64_t xf_init_dispatch_time_us(void)
+{
+#if defined(XF_INIT_GET_TIME_US)
+    return (uint64_t)XF_INIT_GET_TIME_US();
+#elif defined(__unix__) || defined(__APPLE__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#else
+    return 0;
+#endif
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void xf_init_dispatch_run_job(xf_init_dispatch_job_t *p_job)
+{
+    if (NULL == p_job->func) {
+        p_job->result = 0;
+        return;
+    }
+    p_job->result = xf_init_dispatch_call((xf_init_stage_t)p_job->stage, p_job->level,
+                                          p_job->func, p_job->func_name);
+}
+
+#if XF_INIT_USE_PARALLEL
+
+/* 线程在第一次并发执行时创建, 之后常驻等待, 避免每次唤醒都重新创建线程 */
+static void xf_init_dispatch_pool_start(void)
+{
+    pthread_t thread;
+    unsigned i;
+    if (s_pool.started) {
+        return;
+    }
+    s_pool.started = true;
+    for (i = 0; i < XF_INIT_PARALLEL_WORKERS; i++) {
+        if (pthread_create(&thread, NULL, xf_init_dispatch_worker, NULL) != 0) {
+            XF_LOGW(TAG, "only %u parallel workers started.", i);
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+/*
+ * 调用时持有 s_pool.lock. 按提交顺序找第一个所需资源令牌都有空余的任务,
+ * 与正在执行的任务冲突的任务被跳过, 留到令牌释放后再领取.
+ */
+static xf_init_dispatch_job_t *xf_init_dispatch_pool_take(void)
+{
+    size_t i;
+
+    for (i = s_pool.next; i < s_pool.count; i++) {
+        xf_init_dispatch_job_t *p_job = &s_pool.p_jobs[i];
+        if (p_job->taken) {
+            continue;
+        }
+#if XF_INIT_ENABLE_RESOURCE
+        if ((NULL != p_job->resource) && !xf_init_resource_try_acquire(p_job->resource)) {
+            continue;
+        }
+#endif
+        p_job->taken = true;
+        while ((s_pool.next < s_pool.count) && s_pool.p_jobs[s_pool.next].taken) {
+            s_pool.next++;
+        }
+        return p_job;
+    }
+    return NULL;
+}
+
+/* 调用时持有 s_pool.lock */
+static void xf_init_dispatch_pool_finish(xf_init_dispatch_job_t *p_job)
+{
+    bool wake = (++s_pool.done == s_pool.count);
+
+#if XF_INIT_ENABLE_RESOURCE
+    if (NULL != p_job->resource) {
+        /* 令牌释放后, 等资源的任务可能可以执行了 */
+        xf_init_resource_release(p_job->resource);
+        pthread_cond_broadcast(&s_pool.cond_work);
+        wake = true;
+    }
+#else
+    UNUSED(p_job);
+#endif
+    if (wake) {
+        pthread_cond_signal(&s_pool.cond_done);
+    }
+}
+
+static void *xf_init_dispatch_worker(void *arg)
+{
+    xf_init_dispatch_job_t *p_job;
+
+    UNUSED(arg);
+    tl_worker = true;
+    pthread_mutex_lock(&s_pool.lock);
+    for (;;) {
+        while (NULL == (p_job = xf_init_dispatch_pool_take())) {
+            pthread_cond_wait(&s_pool.cond_work, &s_pool.lock);
+        }
+        pthread_mutex_unlock(&s_pool.lock);
+        xf_init_dispatch_run_job(p_job);
+        pthread_mutex_lock(&s_pool.lock);
+        xf_init_dispatch_pool_finish(p_job);
+    }
+    return NULL;
+}
+
+#endif /* XF_INIT_USE_PARALLEL */
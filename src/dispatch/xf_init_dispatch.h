@@ -0,0 +1,169 @@
+/**
+ * @file xf_init_dispatch.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 各实现方式共用的调用逻辑（计时、统计、并发执行）。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_DISPATCH_H__
+#define __XF_INIT_DISPATCH_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+/**
+ * @cond XFAPI_INTERNAL
+ * @ingroup group_xf_init_internal
+ * @defgroup group_xf_init_internal_dispatch dispatch
+ * @brief section / registry 共用的调用逻辑。
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * @brief 等级编号, 与 section 模式的段名后缀一致, registry 模式为类型加一.
+ */
+#define XF_INIT_LEVEL_SETUP         1
+#define XF_INIT_LEVEL_BOARD         2
+#define XF_INIT_LEVEL_PREV          3
+#define XF_INIT_LEVEL_CLEANUP       4
+#define XF_INIT_LEVEL_DEVICE        5
+#define XF_INIT_LEVEL_COMPONENT     6
+#define XF_INIT_LEVEL_ENV           7
+#define XF_INIT_LEVEL_APP           8
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 调用阶段.
+ */
+typedef enum _xf_init_stage_t {
+    XF_INIT_STAGE_INIT = 0x00,              /*!< 初始化 */
+    XF_INIT_STAGE_SUSPEND,                  /*!< 挂起 */
+    XF_INIT_STAGE_RESUME,                   /*!< 恢复 */
+    XF_INIT_STAGE_POSTFORK,                 /*!< fork 后重新初始化 */
+    XF_INIT_STAGE_WARMUP,                   /*!< 初始化完成后预热 */
+
+    XF_INIT_STAGE_MAX,
+} xf_init_stage_t;
+
+/**
+ * @brief 一次调用的描述, 并发执行时使用.
+ */
+typedef struct _xf_init_dispatch_job_t {
+    int (*func)(void);                      /*!< 被调用的函数 */
+    const char *func_name;                  /*!< 函数名 */
+    uint8_t stage;                          /*!< 阶段, 见 @ref xf_init_stage_t */
+    uint8_t level;                          /*!< 等级, 见 XF_INIT_LEVEL_* */
+    bool taken;                             /*!< 已被领取, 由调度维护 */
+    const char *resource;                   /*!< 所需的资源令牌, 逗号分隔, 可为 NULL */
+    int result;                             /*!< 执行后的返回值 */
+} xf_init_dispatch_job_t;
+
+/**
+ * @brief 遍历初始化函数时的回调.
+ *
+ * @param index 序号, 与执行顺序一致.
+ * @param func_name 函数名.
+ * @param level 等级.
+ * @param user_data 用户数据.
+ * @return bool 返回 false 时停止遍历.
+ */
+typedef bool (*xf_init_dispatch_entry_cb_t)(size_t index, const char *func_name, uint8_t level, void *user_data);
+
+/**
+ * @brief 按执行顺序遍历所有初始化函数, 由 section / registry 各自实现.
+ */
+typedef void (*xf_init_dispatch_for_each_t)(xf_init_dispatch_entry_cb_t cb, void *user_data);
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief （内部函数）调用一个初始化 / 挂起 / 恢复函数, 并记录日志与统计.
+ *
+ * @param stage 阶段.
+ * @param level 等级.
+ * @param func 函数.
+ * @param func_name 函数名.
+ * @return int 函数的返回值.
+ */
+int xf_init_dispatch_call(xf_init_stage_t stage, uint8_t level, int (*func)(void), const char *func_name);
+
+/**
+ * @brief （内部函数）并发执行一批相互独立的函数, 全部完成后返回.
+ *
+ * 未开启并发时按顺序执行.
+ *
+ * @param p_jobs 任务数组, 执行后 result 为各函数的返回值.
+ * @param count 任务个数.
+ * @return int 第一个非 0 的返回值, 全部成功时为 0.
+ */
+int xf_init_dispatch_parallel(xf_init_dispatch_job_t *p_jobs, size_t count);
+
+/**
+ * @brief （内部函数）初始化阶段即将执行高于 level 的等级时调用.
+ *
+ * 开启 `XF_INIT_ENABLE_CORO` 时在这里运行事件循环, 直到这些等级中的协程结束;
+ * 开启 `XF_INIT_ENABLE_RETRY` 时在这里等待依赖方需要等待的重试结束.
+ *
+ * @param level 已执行完的等级.
+ */
+void xf_init_dispatch_level_done(uint8_t level);
+
+/**
+ * @brief （内部函数）fork 之后在子进程中调用, 丢弃从父进程继承的线程池状态.
+ *
+ * 子进程中只有调用 fork 的线程存活, 线程池会在下一次并发执行时重新创建.
+ */
+void xf_init_dispatch_atfork_child(void);
+
+/**
+ * @brief （内部函数）获取并发调度锁, 修改调度时读取的状态 (如资源令牌) 前调用.
+ *
+ * 未开启并发时为空操作. 不可在并发执行的函数中调用.
+ */
+void xf_init_dispatch_lock(void);
+
+/**
+ * @brief （内部函数）释放 @ref xf_init_dispatch_lock 获取的锁.
+ */
+void xf_init_dispatch_unlock(void);
+
+/**
+ * @brief （内部函数）当前线程是否为并发执行的工作线程.
+ *
+ * 必须在调用 xf_init 的线程上执行的函数 (如 per thread 初始化) 据此推迟到本批次结束后执行.
+ *
+ * @return bool 未开启并发时总是 false.
+ */
+bool xf_init_dispatch_in_worker(void);
+
+/**
+ * @brief （内部函数）获取微秒时间戳.
+ *
+ * @return uint64_t 时间戳.
+ */
+uint64_t xf_init_dispatch_time_us(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_internal_dispatch
+ * @}
+ */
+
+#endif /* __XF_INIT_DISPATCH_H__ */
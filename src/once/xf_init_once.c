@@ -0,0 +1,236 @@
+/**
+ * @file xf_init_once.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 同一主机上多个进程之间只执行一次的初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_once.h"
+
+#if XF_INIT_ENABLE_HOST_ONCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "once"
+
+/* 槽位数不同的进程不能共用同一块共享内存, 因此把槽位数计入标识 */
+#define XF_INIT_ONCE_MAGIC              (0x78664f01u ^ (uint32_t)XF_INIT_HOST_ONCE_SLOTS)
+#define XF_INIT_ONCE_NAME_SIZE          48
+
+#define XF_INIT_ONCE_EMPTY              0u
+#define XF_INIT_ONCE_RUNNING            1u
+#define XF_INIT_ONCE_DONE               2u
+#define XF_INIT_ONCE_FAILED             3u
+
+/*
+ * 执行权用共享内存对象上按槽位划分的字节锁表示, 持有者退出 (包括崩溃) 时由内核释放,
+ * 不依赖 pid, 因此不受 pid 复用与 pid 命名空间影响.
+ * OFD 锁属于打开的文件描述, 每次调用单独打开, 同一进程的不同线程之间也互相排斥;
+ * 没有 OFD 锁的系统退化为进程级的 POSIX 记录锁, 只在进程之间排斥.
+ */
+#if defined(F_OFD_SETLKW)
+#   define XF_INIT_ONCE_SETLKW          F_OFD_SETLKW
+#else
+#   define XF_INIT_ONCE_SETLKW          F_SETLKW
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct _xf_init_once_slot_t {
+    uint64_t key;                           /*!< 名字的哈希, 0 表示空闲 */
+    uint32_t state;                         /*!< XF_INIT_ONCE_*, 只在持有槽位锁时修改 */
+    int32_t result;                         /*!< 最后一次执行的返回值 */
+    char name[XF_INIT_ONCE_NAME_SIZE];      /*!< 名字, 仅用于调试 */
+} xf_init_once_slot_t;
+
+typedef struct _xf_init_once_shm_t {
+    uint32_t magic;
+    xf_init_once_slot_t slots[XF_INIT_HOST_ONCE_SLOTS];
+} xf_init_once_shm_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static xf_init_once_shm_t *xf_init_once_map(void);
+static xf_init_once_slot_t *xf_init_once_slot(xf_init_once_shm_t *p_shm, const char *name);
+static uint64_t xf_init_once_hash(const char *name);
+static int xf_init_once_lock(xf_init_once_shm_t *p_shm, xf_init_once_slot_t *p_slot);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_once_shm_t *s_shm = NULL;
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_init_host_once(const char *name, int (*func)(void))
+{
+    xf_init_once_shm_t *p_shm = xf_init_once_map();
+    xf_init_once_slot_t *p_slot = p_shm ? xf_init_once_slot(p_shm, name) : NULL;
+    uint32_t state;
+    int lock_fd;
+    int result;
+
+    if (NULL == p_slot) {
+        XF_LOGW(TAG, "%s: shared state unavailable, run locally.", name);
+        return func();
+    }
+    if (__atomic_load_n(&p_slot->state, __ATOMIC_ACQUIRE) == XF_INIT_ONCE_DONE) {
+        XF_LOGD(TAG, "%s already done by another process.", name);
+        return 0;
+    }
+
+    /* 其他进程正在执行时在此阻塞, 直到其完成或退出 */
+    lock_fd = xf_init_once_lock(p_shm, p_slot);
+    if (lock_fd < 0) {
+        XF_LOGW(TAG, "%s: lock unavailable (%s), run locally.", name, strerror(errno));
+        return func();
+    }
+
+    state = __atomic_load_n(&p_slot->state, __ATOMIC_ACQUIRE);
+    if (state == XF_INIT_ONCE_DONE) {
+        close(lock_fd);
+        XF_LOGD(TAG, "%s already done by another process.", name);
+        return 0;
+    }
+    if (state == XF_INIT_ONCE_RUNNING) {
+        /* 拿到了锁而状态仍为执行中, 说明上一个执行者中途退出 */
+        XF_LOGW(TAG, "%s: previous owner died, take over.", name);
+    }
+
+    __atomic_store_n(&p_slot->state, XF_INIT_ONCE_RUNNING, __ATOMIC_RELAXED);
+    result = func();
+    p_slot->result = result;
+    __atomic_store_n(&p_slot->state, (result == 0) ? XF_INIT_ONCE_DONE : XF_INIT_ONCE_FAILED,
+                     __ATOMIC_RELEASE);
+    close(lock_fd);
+    return result;
+}
+
+xf_err_t xf_init_host_once_reset(void)
+{
+    if (s_shm) {
+        munmap(s_shm, sizeof(*s_shm));
+        s_shm = NULL;
+    }
+    if ((shm_unlink(XF_INIT_HOST_ONCE_SHM_NAME) != 0) && (errno != ENOENT)) {
+        return XF_FAIL;
+    }
+    return XF_OK;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static xf_init_once_shm_t *xf_init_once_map(void)
+{
+    xf_init_once_shm_t *p_shm;
+    struct stat st;
+    int fd;
+
+    if (s_shm) {
+        return s_shm;
+    }
+
+    fd = shm_open(XF_INIT_HOST_ONCE_SHM_NAME, O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        return NULL;
+    }
+    /* 新建的共享内存长度为 0, 扩展后内容全为 0, 即所有槽位空闲; 已存在时不会截断 */
+    if ((fstat(fd, &st) != 0)
+            || ((st.st_size < (off_t)sizeof(*p_shm)) && (ftruncate(fd, sizeof(*p_shm)) != 0))) {
+        close(fd);
+        return NULL;
+    }
+    p_shm = mmap(NULL, sizeof(*p_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p_shm == MAP_FAILED) {
+        return NULL;
+    }
+
+    uint32_t magic = 0;
+    if (!__atomic_compare_exchange_n(&p_shm->magic, &magic, XF_INIT_ONCE_MAGIC, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+            && (magic != XF_INIT_ONCE_MAGIC)) {
+        XF_LOGE(TAG, "%s has an incompatible layout.", XF_INIT_HOST_ONCE_SHM_NAME);
+        munmap(p_shm, sizeof(*p_shm));
+        return NULL;
+    }
+
+    s_shm = p_shm;
+    return s_shm;
+}
+
+/* 开放寻址, 用 CAS 抢占空槽位, 不需要锁, 任何进程崩溃都不会留下锁 */
+static xf_init_once_slot_t *xf_init_once_slot(xf_init_once_shm_t *p_shm, const char *name)
+{
+    uint64_t key = xf_init_once_hash(name);
+    for (unsigned i = 0; i < XF_INIT_HOST_ONCE_SLOTS; i++) {
+        xf_init_once_slot_t *p_slot = &p_shm->slots[(key + i) % XF_INIT_HOST_ONCE_SLOTS];
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n(&p_slot->key, &expected, key, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            strncpy(p_slot->name, name, sizeof(p_slot->name) - 1);
+            return p_slot;
+        }
+        if (expected == key) {
+            return p_slot;
+        }
+    }
+    XF_LOGE(TAG, "no free slot for %s, increase XF_INIT_HOST_ONCE_SLOTS.", name);
+    return NULL;
+}
+
+/* FNV-1a, 0 保留为空闲 */
+static uint64_t xf_init_once_hash(const char *name)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (; *name; name++) {
+        hash ^= (uint8_t)*name;
+        hash *= 0x100000001b3ull;
+    }
+    return hash ? hash : 1;
+}
+
+/* 阻塞直到获得槽位锁, 返回持有锁的 fd, 关闭即释放 */
+static int xf_init_once_lock(xf_init_once_shm_t *p_shm, xf_init_once_slot_t *p_slot)
+{
+    struct flock lock = {
+        .l_type     = F_WRLCK,
+        .l_whence   = SEEK_SET,
+        .l_start    = (off_t)((uintptr_t)p_slot - (uintptr_t)p_shm),
+        .l_len      = 1,
+    };
+    int fd = shm_open(XF_INIT_HOST_ONCE_SHM_NAME, O_RDWR | O_CLOEXEC, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+    while (fcntl(fd, XF_INIT_ONCE_SETLKW, &lock) != 0) {
+        if (errno != EINTR) {
+            int saved_errno = errno;
+            close(fd);
+            errno = saved_errno;
+            return -1;
+        }
+    }
+    return fd;
+}
+
+#endif /* XF_INIT_ENABLE_HOST_ONCE */
@@ -0,0 +1,99 @@
+/**
+ * @file xf_init_once.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 同一主机上多个进程之间只执行一次的初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_ONCE_H__
+#define __XF_INIT_ONCE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_HOST_ONCE || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_once host once
+ * @brief 主机级的初始化 (创建共享环形缓冲区、加载固件、配置网卡等) 只由第一个进程执行。
+ * 需要开启 `XF_INIT_ENABLE_HOST_ONCE`.
+ *
+ * 完成状态保存在名为 `XF_INIT_HOST_ONCE_SHM_NAME` 的共享内存中:
+ * - 第一个进程执行, 其他进程阻塞在该函数的锁上等待其完成, 完成后直接跳过;
+ * - 锁由内核在执行者退出时释放, 执行者中途崩溃时下一个等待者立即接手重新执行;
+ * - 执行失败时不记录为完成, 下一个进程会重新执行.
+ *
+ * 状态在主机重启 (或 @ref xf_init_host_once_reset) 前一直有效.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 在同一主机的所有进程中只执行一次 func.
+ *
+ * @param name 全局唯一的名字.
+ * @param func 初始化函数.
+ * @return int
+ *      - 本进程执行时为 func 的返回值
+ *      - 其他进程已完成时为 0
+ *      - 共享内存不可用时退化为直接执行 func
+ */
+int xf_init_host_once(const char *name, int (*func)(void));
+
+/**
+ * @brief 删除共享内存, 之后所有主机级初始化函数都会重新执行一次.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   删除失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_host_once_reset(void);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * @brief 导出主机级初始化函数, 在指定等级内与普通初始化函数一起执行.
+ *
+ * 实际注册的函数名为 `function_host_once`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_host_once)`.
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 SETUP.
+ */
+#define XF_INIT_EXPORT_HOST_ONCE(function, level) \
+    static int function##_host_once(void) \
+    { \
+        return xf_init_host_once(#function, function); \
+    } \
+    XF_INIT_EXPORT_##level(function##_host_once)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_once
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_HOST_ONCE */
+
+#endif /* __XF_INIT_ONCE_H__ */
@@ -0,0 +1,301 @@
+/**
+ * @file xf_init_percpu.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 在每个 CPU / 每个线程上执行的初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_percpu.h"
+
+#if XF_INIT_ENABLE_PER_CPU
+
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <pthread.h>
+#endif
+
+#if defined(__linux__)
+#   include <sched.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "percpu"
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define XF_INIT_PER_CPU_USE_PTHREAD  1
+#else
+#   define XF_INIT_PER_CPU_USE_PTHREAD  0
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+#if defined(__linux__)
+typedef struct _xf_init_per_cpu_job_t {
+    xf_init_per_cpu_entry_t *p_entry;
+    unsigned cpu;
+    int result;
+    pthread_t thread;
+    bool started;
+} xf_init_per_cpu_job_t;
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void xf_init_per_cpu_link(xf_init_per_cpu_entry_t *p_entry);
+static xf_init_per_cpu_entry_t *xf_init_per_cpu_find(const char *func_name);
+static void xf_init_per_cpu_mark(xf_init_per_cpu_entry_t *p_entry, unsigned cpu, int result);
+static unsigned xf_init_per_cpu_current(void);
+
+#if defined(__linux__)
+static void *xf_init_per_cpu_worker(void *arg);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_per_cpu_entry_t *s_head = NULL;
+static xf_init_per_cpu_entry_t *s_tail = NULL;
+
+/* 本线程已执行到的 per thread 函数, 链表只在尾部追加 */
+static __thread xf_init_per_cpu_entry_t *tl_last = NULL;
+
+#if XF_INIT_PER_CPU_USE_PTHREAD
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#if defined(__linux__)
+/* 并发初始化时同一等级的多个函数可能同时扇出, 任务表同一时间只给一个函数使用 */
+static pthread_mutex_t s_run_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+#if XF_INIT_PER_CPU_USE_PTHREAD
+#   define xf_init_per_cpu_lock()       pthread_mutex_lock(&s_lock)
+#   define xf_init_per_cpu_unlock()     pthread_mutex_unlock(&s_lock)
+#else
+#   define xf_init_per_cpu_lock()
+#   define xf_init_per_cpu_unlock()
+#endif
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_init_per_cpu_run(xf_init_per_cpu_entry_t *p_entry)
+{
+    int result = 0;
+
+    xf_init_per_cpu_link(p_entry);
+
+#if defined(__linux__)
+    /* 由 s_run_lock 保证同一时间只有一个函数在扇出, 任务表可以静态分配 */
+    static xf_init_per_cpu_job_t s_jobs[XF_INIT_PER_CPU_MAX];
+    cpu_set_t online;
+    unsigned cpu;
+    size_t count = 0;
+    size_t i;
+
+    pthread_mutex_lock(&s_run_lock);
+
+    /* 只在本进程允许运行的 CPU 上执行 (受 taskset / cgroup 限制) */
+    if (sched_getaffinity(0, sizeof(online), &online) != 0) {
+        CPU_ZERO(&online);
+        CPU_SET(xf_init_per_cpu_current(), &online);
+    }
+
+    for (cpu = 0; (cpu < XF_INIT_PER_CPU_MAX) && (cpu < CPU_SETSIZE); cpu++) {
+        pthread_attr_t attr;
+        cpu_set_t set;
+        xf_init_per_cpu_job_t *p_job;
+
+        if (!CPU_ISSET(cpu, &online)) {
+            continue;
+        }
+        p_job = &s_jobs[count++];
+        *p_job = (xf_init_per_cpu_job_t) {
+            .p_entry    = p_entry,
+            .cpu        = cpu,
+        };
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        p_job->started = (pthread_create(&p_job->thread, &attr, xf_init_per_cpu_worker, p_job) == 0);
+        pthread_attr_destroy(&attr);
+        if (!p_job->started) {
+            XF_LOGW(TAG, "%s: failed to start thread on cpu %u, run unpinned.", p_entry->func_name, cpu);
+            xf_init_per_cpu_worker(p_job);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (s_jobs[i].started) {
+            pthread_join(s_jobs[i].thread, NULL);
+        }
+        if ((result == 0) && (s_jobs[i].result != 0)) {
+            result = s_jobs[i].result;
+        }
+    }
+    pthread_mutex_unlock(&s_run_lock);
+    XF_LOGD(TAG, "%s done on %u cpus.", p_entry->func_name, (unsigned)count);
+#else
+    result = p_entry->func(0);
+    xf_init_per_cpu_mark(p_entry, 0, result);
+#endif
+
+    return result;
+}
+
+int xf_init_per_thread_run(xf_init_per_cpu_entry_t *p_entry)
+{
+    xf_init_per_cpu_link(p_entry);
+    /* 并发初始化时可能被工作线程领取, 由调度在本批次结束后于调用线程上执行 */
+    if (xf_init_dispatch_in_worker()) {
+        XF_LOGD(TAG, "%s deferred to the calling thread.", p_entry->func_name);
+        return 0;
+    }
+    return xf_init_per_thread_attach();
+}
+
+int xf_init_per_thread_attach(void)
+{
+    xf_init_per_cpu_entry_t *p_entry;
+    int result = 0;
+
+    for (;;) {
+        xf_init_per_cpu_lock();
+        p_entry = tl_last ? tl_last->p_next : s_head;
+        xf_init_per_cpu_unlock();
+        if (NULL == p_entry) {
+            break;
+        }
+        tl_last = p_entry;
+        if (p_entry->per_thread) {
+            unsigned cpu = xf_init_per_cpu_current();
+            int ret = p_entry->func(cpu);
+            xf_init_per_cpu_mark(p_entry, cpu, ret);
+            if ((result == 0) && (ret != 0)) {
+                result = ret;
+            }
+        }
+    }
+
+    return result;
+}
+
+xf_err_t xf_init_per_cpu_state(const char *func_name, unsigned cpu)
+{
+    xf_init_per_cpu_entry_t *p_entry = xf_init_per_cpu_find(func_name);
+    uint32_t bit;
+
+    if (NULL == p_entry) {
+        return XF_ERR_NOT_FOUND;
+    }
+    if (cpu >= XF_INIT_PER_CPU_MAX) {
+        return XF_ERR_NOT_FINISHED;
+    }
+    bit = 1u << (cpu & 31);
+    if (!(__atomic_load_n(&p_entry->done_mask[cpu >> 5], __ATOMIC_ACQUIRE) & bit)) {
+        return XF_ERR_NOT_FINISHED;
+    }
+    return (__atomic_load_n(&p_entry->failed_mask[cpu >> 5], __ATOMIC_ACQUIRE) & bit) ? XF_FAIL : XF_OK;
+}
+
+size_t xf_init_per_cpu_done_count(const char *func_name)
+{
+    xf_init_per_cpu_entry_t *p_entry = xf_init_per_cpu_find(func_name);
+    size_t count = 0;
+    size_t i;
+
+    if (NULL == p_entry) {
+        return 0;
+    }
+    for (i = 0; i < XF_INIT_PER_CPU_MASK_WORDS; i++) {
+        uint32_t ok = __atomic_load_n(&p_entry->done_mask[i], __ATOMIC_ACQUIRE)
+                      & ~__atomic_load_n(&p_entry->failed_mask[i], __ATOMIC_ACQUIRE);
+        count += (size_t)__builtin_popcount(ok);
+    }
+    return count;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void xf_init_per_cpu_link(xf_init_per_cpu_entry_t *p_entry)
+{
+    xf_init_per_cpu_lock();
+    if (!p_entry->linked) {
+        p_entry->linked = true;
+        p_entry->p_next = NULL;
+        if (s_tail) {
+            s_tail->p_next = p_entry;
+        } else {
+            s_head = p_entry;
+        }
+        s_tail = p_entry;
+    }
+    xf_init_per_cpu_unlock();
+}
+
+static xf_init_per_cpu_entry_t *xf_init_per_cpu_find(const char *func_name)
+{
+    xf_init_per_cpu_entry_t *p_entry;
+
+    if (NULL == func_name) {
+        return NULL;
+    }
+    xf_init_per_cpu_lock();
+    for (p_entry = s_head; p_entry; p_entry = p_entry->p_next) {
+        if (strcmp(p_entry->func_name, func_name) == 0) {
+            break;
+        }
+    }
+    xf_init_per_cpu_unlock();
+    return p_entry;
+}
+
+/* 各 CPU 上的线程同时完成, 位图用原子操作更新 */
+static void xf_init_per_cpu_mark(xf_init_per_cpu_entry_t *p_entry, unsigned cpu, int result)
+{
+    uint32_t bit = 1u << (cpu & 31);
+    if (cpu >= XF_INIT_PER_CPU_MAX) {
+        return;
+    }
+    if (result != 0) {
+        __atomic_fetch_or(&p_entry->failed_mask[cpu >> 5], bit, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_or(&p_entry->done_mask[cpu >> 5], bit, __ATOMIC_RELEASE);
+}
+
+static unsigned xf_init_per_cpu_current(void)
+{
+#if defined(__linux__)
+    int cpu = sched_getcpu();
+    return (cpu < 0) ? 0u : (unsigned)cpu;
+#else
+    return 0;
+#endif
+}
+
+#if defined(__linux__)
+
+static void *xf_init_per_cpu_worker(void *arg)
+{
+    xf_init_per_cpu_job_t *p_job = (xf_init_per_cpu_job_t *)arg;
+    p_job->result = p_job->p_entry->func(p_job->cpu);
+    xf_init_per_cpu_mark(p_job->p_entry, p_job->cpu, p_job->result);
+    return NULL;
+}
+
+#endif /* defined(__linux__) */
+
+#endif /* XF_INIT_ENABLE_PER_CPU */
@@ -0,0 +1,178 @@
+/**
+ * @file xf_init_percpu.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 在每个 CPU / 每个线程上执行的初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_PERCPU_H__
+#define __XF_INIT_PERCPU_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_PER_CPU || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_percpu per cpu
+ * @brief 每个 CPU 一份的状态 (内存池、线程缓存、队列等) 由 xf_init 统一扇出初始化.
+ * 需要开启 `XF_INIT_ENABLE_PER_CPU`.
+ *
+ * - @ref XF_INIT_EXPORT_PER_CPU: 在所属等级内, 每个可用 CPU 上各启动一个绑定到该 CPU 的线程,
+ *   并发执行 `function(cpu)`, 内存由本 CPU 第一次写入, 按 NUMA 就近分配;
+ * - @ref XF_INIT_EXPORT_PER_THREAD: 在所属等级内对调用 xf_init 的线程执行一次,
+ *   之后创建的线程在开始时调用 @ref xf_init_per_thread_attach 补齐.
+ *   开启 `XF_INIT_ENABLE_PARALLEL_INIT` 时不在工作线程上执行, 而是在同一批并发函数结束后回到调用线程执行.
+ *
+ * 仅 Linux 支持绑核, 其他平台只在当前线程上以 cpu 0 执行一次.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define XF_INIT_PER_CPU_MASK_WORDS  ((XF_INIT_PER_CPU_MAX + 31) / 32)
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 每个 CPU / 线程上执行的初始化函数.
+ *
+ * @param cpu CPU 编号.
+ * @return int 0 表示成功.
+ */
+typedef int (*xf_init_per_cpu_fn_t)(unsigned cpu);
+
+/**
+ * @brief （内部使用）由 @ref XF_INIT_EXPORT_PER_CPU / @ref XF_INIT_EXPORT_PER_THREAD 静态定义.
+ */
+typedef struct _xf_init_per_cpu_entry_t {
+    xf_init_per_cpu_fn_t func;              /*!< 初始化函数 */
+    const char *func_name;                  /*!< 函数名 */
+
+    /* 以下由 percpu 模块维护 */
+    uint32_t done_mask[XF_INIT_PER_CPU_MASK_WORDS];     /*!< 已执行的 CPU */
+    uint32_t failed_mask[XF_INIT_PER_CPU_MASK_WORDS];   /*!< 返回非 0 的 CPU */
+    bool per_thread;                        /*!< 由 XF_INIT_EXPORT_PER_THREAD 导出 */
+    bool linked;                            /*!< 已加入链表 */
+    struct _xf_init_per_cpu_entry_t *p_next;
+} xf_init_per_cpu_entry_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 查询每个 CPU 上的初始化函数在某个 CPU 上的执行结果.
+ *
+ * 对 @ref XF_INIT_EXPORT_PER_THREAD 导出的函数, cpu 为执行时线程所在的 CPU.
+ *
+ * @param func_name 函数名.
+ * @param cpu CPU 编号.
+ * @return xf_err_t
+ *      - XF_ERR_NOT_FOUND          函数不存在或所属等级尚未执行
+ *      - XF_ERR_NOT_FINISHED       未在该 CPU 上执行
+ *      - XF_FAIL                   返回了非 0
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_per_cpu_state(const char *func_name, unsigned cpu);
+
+/**
+ * @brief 获取在多少个 CPU 上执行成功.
+ *
+ * @param func_name 函数名.
+ * @return size_t 个数, 函数不存在时为 0.
+ */
+size_t xf_init_per_cpu_done_count(const char *func_name);
+
+/**
+ * @brief 新线程开始时调用, 在本线程上执行所有已到达所属等级的 per thread 初始化函数.
+ *
+ * 可以重复调用, 每个函数在每个线程上只执行一次; 之后再到达的等级需要再次调用.
+ *
+ * @return int 第一个非 0 的返回值, 全部成功时为 0.
+ */
+int xf_init_per_thread_attach(void);
+
+/**
+ * @brief （内部函数）在每个可用 CPU 上绑核并发执行. 由 @ref XF_INIT_EXPORT_PER_CPU 生成的函数调用.
+ *
+ * @param p_entry 初始化函数.
+ * @return int 第一个非 0 的返回值, 全部成功时为 0.
+ */
+int xf_init_per_cpu_run(xf_init_per_cpu_entry_t *p_entry);
+
+/**
+ * @brief （内部函数）登记并在当前线程上执行. 由 @ref XF_INIT_EXPORT_PER_THREAD 生成的函数调用.
+ *
+ * @param p_entry 初始化函数.
+ * @return int 同 @ref xf_init_per_thread_attach.
+ */
+int xf_init_per_thread_run(xf_init_per_cpu_entry_t *p_entry);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * @brief 导出在每个可用 CPU 上执行的初始化函数, 类型为 @ref xf_init_per_cpu_fn_t.
+ *
+ * 实际注册的函数名为 `function_per_cpu`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_per_cpu)`.
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 COMPONENT.
+ */
+#define XF_INIT_EXPORT_PER_CPU(function, level) \
+    static xf_init_per_cpu_entry_t __xf_init_per_cpu_##function = { \
+        .func       = (function), \
+        .func_name  = #function, \
+    }; \
+    static int function##_per_cpu(void) \
+    { \
+        return xf_init_per_cpu_run(&__xf_init_per_cpu_##function); \
+    } \
+    XF_INIT_EXPORT_##level(function##_per_cpu)
+
+/**
+ * @brief 导出在每个线程上执行的初始化函数, 类型为 @ref xf_init_per_cpu_fn_t.
+ *
+ * 实际注册的函数名为 `function_per_thread`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_per_thread)`.
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 COMPONENT.
+ */
+#define XF_INIT_EXPORT_PER_THREAD(function, level) \
+    static xf_init_per_cpu_entry_t __xf_init_per_thread_##function = { \
+        .func       = (function), \
+        .func_name  = #function, \
+        .per_thread = true, \
+    }; \
+    static int function##_per_thread(void) \
+    { \
+        return xf_init_per_thread_run(&__xf_init_per_thread_##function); \
+    } \
+    XF_INIT_EXPORT_##level(function##_per_thread)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_percpu
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_PER_CPU */
+
+#endif /* __XF_INIT_PERCPU_H__ */
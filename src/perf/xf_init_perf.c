@@ -0,0 +1,296 @@
+/**
+ * @file xf_init_perf.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 基于 perf_event_open 的性能计数器采样。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_perf.h"
+
+#if XF_INIT_ENABLE_PERF_COUNTERS
+#   include <stddef.h>
+#   include <string.h>
+#endif
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && defined(__linux__)
+#   include <pthread.h>
+#   include <unistd.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "perf"
+
+/* ==================== [Typedefs] ========================================== */
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && defined(__linux__)
+typedef struct _xf_init_perf_event_t {
+    uint32_t type;
+    uint64_t config;
+} xf_init_perf_event_t;
+
+/* 一个线程的计数器组 */
+typedef struct _xf_init_perf_thread_t {
+    int fd[XF_INIT_PERF_MAX];               /*!< 打不开的为 -1 */
+    uint64_t id[XF_INIT_PERF_MAX];          /*!< 组读取结果按 id 对应到计数器 */
+    int leader;                             /*!< 组长, 一个都打不开时为 -1 */
+    bool opened;
+    struct _xf_init_perf_thread_t *p_next;  /*!< 所有打开过计数器的线程 */
+} xf_init_perf_thread_t;
+
+/* PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_* 的读取结果 */
+typedef struct _xf_init_perf_group_read_t {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    struct {
+        uint64_t value;
+        uint64_t id;
+    } values[XF_INIT_PERF_MAX];
+} xf_init_perf_group_read_t;
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && defined(__linux__)
+static void xf_init_perf_open(xf_init_perf_thread_t *p_thread);
+static int xf_init_perf_open_one(const xf_init_perf_event_t *p_event, int group_fd);
+static void xf_init_perf_close(xf_init_perf_thread_t *p_thread);
+static void xf_init_perf_key_create(void);
+static void xf_init_perf_thread_exit(void *arg);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static const char *const s_perf_name[XF_INIT_PERF_MAX] = {
+    [XF_INIT_PERF_CYCLES]           = "cycles",
+    [XF_INIT_PERF_INSTRUCTIONS]     = "instructions",
+    [XF_INIT_PERF_CACHE_MISSES]     = "cache-misses",
+    [XF_INIT_PERF_PAGE_FAULTS]      = "page-faults",
+    [XF_INIT_PERF_CONTEXT_SWITCHES] = "context-switches",
+};
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && defined(__linux__)
+static const xf_init_perf_event_t s_perf_event[XF_INIT_PERF_MAX] = {
+    [XF_INIT_PERF_CYCLES]           = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [XF_INIT_PERF_INSTRUCTIONS]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [XF_INIT_PERF_CACHE_MISSES]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [XF_INIT_PERF_PAGE_FAULTS]      = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    [XF_INIT_PERF_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+/* 计数器只统计打开它的线程, 因此每个线程各自一组, 线程退出时由 s_perf_key 的析构关闭 */
+static __thread xf_init_perf_thread_t tl_perf;
+static pthread_key_t s_perf_key;
+static pthread_once_t s_perf_key_once = PTHREAD_ONCE_INIT;
+
+/* fork 后子进程只剩一个线程, 其他线程的计数器要靠这个链表找到并关闭 */
+static xf_init_perf_thread_t *s_perf_threads = NULL;
+static pthread_mutex_t s_perf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* 只提示一次 */
+static bool s_perf_warned = false;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+const char *xf_init_perf_name(xf_init_perf_counter_t counter)
+{
+    if ((unsigned)counter >= XF_INIT_PERF_MAX) {
+        return "unknown";
+    }
+    return s_perf_name[counter];
+}
+
+#if XF_INIT_ENABLE_PERF_COUNTERS
+
+void xf_init_perf_read(xf_init_perf_sample_t *p_sample)
+{
+    memset(p_sample, 0, sizeof(*p_sample));
+#if defined(__linux__)
+    xf_init_perf_thread_t *p_thread = &tl_perf;
+    xf_init_perf_group_read_t group;
+    ssize_t size;
+
+    if (!p_thread->opened) {
+        xf_init_perf_open(p_thread);
+    }
+    if (p_thread->leader < 0) {
+        return;
+    }
+
+    /* 整组一次读出, 各计数器的值对应同一段计数时间 */
+    size = read(p_thread->leader, &group, sizeof(group));
+    if ((size < (ssize_t)offsetof(xf_init_perf_group_read_t, values))
+            || (group.nr > XF_INIT_PERF_MAX)
+            || ((size_t)size < offsetof(xf_init_perf_group_read_t, values) + group.nr * sizeof(group.values[0]))) {
+        return;
+    }
+    p_sample->time_enabled = group.time_enabled;
+    p_sample->time_running = group.time_running;
+    for (uint64_t k = 0; k < group.nr; k++) {
+        for (unsigned i = 0; i < XF_INIT_PERF_MAX; i++) {
+            if ((p_thread->fd[i] >= 0) && (p_thread->id[i] == group.values[k].id)) {
+                p_sample->value[i] = group.values[k].value;
+                p_sample->valid_mask |= (uint8_t)(1u << i);
+                break;
+            }
+        }
+    }
+#endif
+}
+
+void xf_init_perf_delta(const xf_init_perf_sample_t *p_begin, xf_init_perf_sample_t *p_end)
+{
+    uint64_t enabled = p_end->time_enabled - p_begin->time_enabled;
+    uint64_t running = p_end->time_running - p_begin->time_running;
+
+    p_end->valid_mask &= p_begin->valid_mask;
+    if ((running == 0) && (enabled != 0)) {
+        /* 整段时间都没有轮到这组计数器 */
+        p_end->valid_mask = 0;
+    }
+    for (unsigned i = 0; i < XF_INIT_PERF_MAX; i++) {
+        uint64_t delta = p_end->value[i] - p_begin->value[i];
+        if (!(p_end->valid_mask & (1u << i))) {
+            delta = 0;
+        } else if (running < enabled) {
+            delta = (uint64_t)((double)delta * (double)enabled / (double)running);
+        }
+        p_end->value[i] = delta;
+    }
+    p_end->time_enabled = enabled;
+    p_end->time_running = running;
+}
+
+void xf_init_perf_atfork_child(void)
+{
+#if defined(__linux__)
+    xf_init_perf_thread_t *p_thread;
+
+    /*
+     * 继承来的描述符仍指向父进程的线程, 包括线程池、重试等子进程中已不存在的线程,
+     * 全部关闭; 本线程在下一次读取时重新打开. 锁可能在 fork 时被其他线程持有, 直接重建.
+     */
+    for (p_thread = s_perf_threads; p_thread; p_thread = p_thread->p_next) {
+        xf_init_perf_close(p_thread);
+    }
+    s_perf_threads = NULL;
+    s_perf_lock = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+#endif
+}
+
+#endif /* XF_INIT_ENABLE_PERF_COUNTERS */
+
+/* ==================== [Static Functions] ================================== */
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && defined(__linux__)
+
+static void xf_init_perf_open(xf_init_perf_thread_t *p_thread)
+{
+    unsigned opened = 0;
+
+    p_thread->opened = true;
+    p_thread->leader = -1;
+    for (unsigned i = 0; i < XF_INIT_PERF_MAX; i++) {
+        /* 第一个打开的计数器作为组长, 其余加入它的组, 一起被调度 */
+        p_thread->fd[i] = xf_init_perf_open_one(&s_perf_event[i], p_thread->leader);
+        if ((p_thread->fd[i] >= 0) && (ioctl(p_thread->fd[i], PERF_EVENT_IOC_ID, &p_thread->id[i]) != 0)) {
+            close(p_thread->fd[i]);
+            p_thread->fd[i] = -1;
+        }
+        if (p_thread->fd[i] >= 0) {
+            if (p_thread->leader < 0) {
+                p_thread->leader = p_thread->fd[i];
+            }
+            opened++;
+        }
+    }
+
+    if (opened > 0) {
+        pthread_once(&s_perf_key_once, xf_init_perf_key_create);
+        pthread_setspecific(s_perf_key, p_thread);
+        pthread_mutex_lock(&s_perf_lock);
+        p_thread->p_next = s_perf_threads;
+        s_perf_threads = p_thread;
+        pthread_mutex_unlock(&s_perf_lock);
+    }
+    if ((opened < XF_INIT_PERF_MAX) && !s_perf_warned) {
+        s_perf_warned = true;
+        XF_LOGW(TAG, "only %u/%u perf counters available (check perf_event_paranoid).",
+                opened, (unsigned)XF_INIT_PERF_MAX);
+    }
+}
+
+static int xf_init_perf_open_one(const xf_init_perf_event_t *p_event, int group_fd)
+{
+    struct perf_event_attr attr;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = p_event->type;
+    attr.config         = p_event->config;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                          | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+        /* perf_event_paranoid >= 2 时普通用户只能统计用户态 */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+/* 组员先关, 组长最后关 */
+static void xf_init_perf_close(xf_init_perf_thread_t *p_thread)
+{
+    for (unsigned i = XF_INIT_PERF_MAX; i-- > 0;) {
+        if (p_thread->fd[i] >= 0) {
+            close(p_thread->fd[i]);
+            p_thread->fd[i] = -1;
+        }
+    }
+    p_thread->leader = -1;
+    p_thread->opened = false;
+}
+
+static void xf_init_perf_key_create(void)
+{
+    pthread_key_create(&s_perf_key, xf_init_perf_thread_exit);
+}
+
+/* 线程退出时关闭它的计数器, 预热等临时线程不会泄漏描述符 */
+static void xf_init_perf_thread_exit(void *arg)
+{
+    xf_init_perf_thread_t *p_thread = (xf_init_perf_thread_t *)arg;
+    xf_init_perf_thread_t **pp;
+
+    pthread_mutex_lock(&s_perf_lock);
+    for (pp = &s_perf_threads; *pp; pp = &(*pp)->p_next) {
+        if (*pp == p_thread) {
+            *pp = p_thread->p_next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_perf_lock);
+    xf_init_perf_close(p_thread);
+}
+
+#endif
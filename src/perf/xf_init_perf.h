@@ -0,0 +1,109 @@
+/**
+ * @file xf_init_perf.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 基于 perf_event_open 的性能计数器采样。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_PERF_H__
+#define __XF_INIT_PERF_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+/**
+ * @cond XFAPI_INTERNAL
+ * @ingroup group_xf_init_internal
+ * @defgroup group_xf_init_internal_perf perf
+ * @brief 每个函数的性能计数器增量, 通过 stats 接口输出。
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 采样的计数器.
+ */
+typedef enum _xf_init_perf_counter_t {
+    XF_INIT_PERF_CYCLES = 0x00,             /*!< CPU 周期 */
+    XF_INIT_PERF_INSTRUCTIONS,              /*!< 指令数 */
+    XF_INIT_PERF_CACHE_MISSES,              /*!< 缓存未命中 */
+    XF_INIT_PERF_PAGE_FAULTS,               /*!< 缺页 */
+    XF_INIT_PERF_CONTEXT_SWITCHES,          /*!< 上下文切换 */
+
+    XF_INIT_PERF_MAX,
+} xf_init_perf_counter_t;
+
+/**
+ * @brief 一次采样.
+ */
+typedef struct _xf_init_perf_sample_t {
+    uint64_t value[XF_INIT_PERF_MAX];       /*!< 各计数器的值, 增量已按实际计数的时间比例换算 */
+    uint64_t time_enabled;                  /*!< 计数器组启用的时间 (ns) */
+    uint64_t time_running;                  /*!< 计数器组实际在 PMU 上计数的时间 (ns), 被复用时小于 time_enabled */
+    uint8_t valid_mask;                     /*!< 有效的计数器, 第 n 位对应 @ref xf_init_perf_counter_t 中的 n */
+} xf_init_perf_sample_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+#if XF_INIT_ENABLE_PERF_COUNTERS || defined(__DOXYGEN__)
+
+/**
+ * @brief （内部函数）读取当前线程的计数器.
+ *
+ * 每个线程第一次调用时把计数器作为一组打开, 一次读取整组, 线程退出时关闭;
+ * 打不开的计数器 (无权限、虚拟机不支持等) 不会出现在 valid_mask 中.
+ *
+ * @param[out] p_sample 采样结果.
+ */
+void xf_init_perf_read(xf_init_perf_sample_t *p_sample);
+
+/**
+ * @brief （内部函数）计算两次采样之间的增量, 只保留两次都有效的计数器.
+ *
+ * 硬件计数器不够而被内核分时复用时, 按 time_enabled / time_running 的增量换算;
+ * 期间计数器组完全没有被调度时没有可用的数据, 所有计数器都视为无效.
+ *
+ * @param p_begin 开始时的采样.
+ * @param[in,out] p_end 结束时的采样, 返回时为增量.
+ */
+void xf_init_perf_delta(const xf_init_perf_sample_t *p_begin, xf_init_perf_sample_t *p_end);
+
+/**
+ * @brief （内部函数）fork 之后在子进程中调用, 关闭从父进程各线程继承的计数器.
+ */
+void xf_init_perf_atfork_child(void);
+
+#endif /* XF_INIT_ENABLE_PERF_COUNTERS */
+
+/**
+ * @brief 获取计数器名称.
+ *
+ * @param counter 计数器.
+ * @return const char* 名称, 如 "cycles".
+ */
+const char *xf_init_perf_name(xf_init_perf_counter_t counter);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_internal_perf
+ * @}
+ */
+
+#endif /* __XF_INIT_PERF_H__ */
@@ -0,0 +1,383 @@
+/**
+ * @file xf_init_profile.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 启动 profile：运行时按规则跳过部分初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_profile.h"
+
+#if XF_INIT_ENABLE_PROFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "profile"
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 文本片段, 不以 '\0' 结尾.
+ */
+typedef struct _xf_init_profile_span_t {
+    const char *p;
+    size_t len;
+} xf_init_profile_span_t;
+
+/**
+ * @brief 按名字查找初始化函数时的上下文.
+ */
+typedef struct _xf_init_profile_find_t {
+    xf_init_profile_span_t name;
+    bool found;
+    bool skipped;
+} xf_init_profile_find_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static const char *xf_init_profile_text(void);
+static bool xf_init_profile_next_line(const char **pp_text, xf_init_profile_span_t *p_line);
+static bool xf_init_profile_next_token(xf_init_profile_span_t *p_line, xf_init_profile_span_t *p_token);
+static bool xf_init_profile_glob(const char *pattern, size_t len, const char *str);
+static bool xf_init_profile_rules_match(const char *text, const char *func_name, uint8_t level);
+static int xf_init_profile_level(const xf_init_profile_span_t *p_name);
+static bool xf_init_profile_dep_line(xf_init_profile_span_t line, const char *func_name,
+                                     xf_init_profile_span_t *p_deps);
+static bool xf_init_profile_check_rules(size_t index, const char *func_name, uint8_t level, void *user_data);
+static bool xf_init_profile_check_deps(size_t index, const char *func_name, uint8_t level, void *user_data);
+static bool xf_init_profile_find(size_t index, const char *func_name, uint8_t level, void *user_data);
+static void xf_init_profile_mark(size_t index);
+
+/* ==================== [Static Variables] ================================== */
+
+static const char *const s_level_name[] = {
+    [XF_INIT_LEVEL_SETUP]       = "SETUP",
+    [XF_INIT_LEVEL_BOARD]       = "BOARD",
+    [XF_INIT_LEVEL_PREV]        = "PREV",
+    [XF_INIT_LEVEL_CLEANUP]     = "CLEANUP",
+    [XF_INIT_LEVEL_DEVICE]      = "DEVICE",
+    [XF_INIT_LEVEL_COMPONENT]   = "COMPONENT",
+    [XF_INIT_LEVEL_ENV]         = "ENV",
+    [XF_INIT_LEVEL_APP]         = "APP",
+};
+
+static const char *s_profile_user = NULL;
+static char s_profile_buf[XF_INIT_PROFILE_TEXT_SIZE];
+
+static xf_init_dispatch_for_each_t s_for_each = NULL;
+static bool s_evaluated = false;
+static bool s_changed = false;
+static size_t s_skipped_count = 0;
+
+uint32_t xf_init_profile_bitmap[(XF_INIT_PROFILE_MAX_ENTRIES + 31) / 32];
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_init_profile_set(const char *text)
+{
+    if (s_evaluated) {
+        return XF_ERR_INVALID_STATE;
+    }
+    s_profile_user = text;
+    return XF_OK;
+}
+
+xf_err_t xf_init_profile_load(const char *path)
+{
+    FILE *fp;
+    size_t len;
+
+    if (s_evaluated) {
+        return XF_ERR_INVALID_STATE;
+    }
+    fp = fopen(path, "r");
+    if (NULL == fp) {
+        return XF_ERR_NOT_FOUND;
+    }
+    len = fread(s_profile_buf, 1, sizeof(s_profile_buf), fp);
+    fclose(fp);
+    if (len >= sizeof(s_profile_buf)) {
+        return XF_ERR_INVALID_SIZE;
+    }
+    s_profile_buf[len] = '\0';
+    s_profile_user = s_profile_buf;
+    return XF_OK;
+}
+
+bool xf_init_profile_is_enabled(const char *func_name)
+{
+    xf_init_profile_find_t find = {
+        .name = { func_name, strlen(func_name) },
+    };
+    if (NULL == s_for_each) {
+        return xf_init_profile_rules_match(xf_init_profile_text(), func_name, 0);
+    }
+    s_for_each(xf_init_profile_find, &find);
+    return find.found && !find.skipped;
+}
+
+size_t xf_init_profile_skipped_count(void)
+{
+    return s_skipped_count;
+}
+
+void xf_init_profile_prepare(xf_init_dispatch_for_each_t for_each)
+{
+    const char *text;
+
+    if (s_evaluated) {
+        return;
+    }
+    s_evaluated = true;
+    s_for_each = for_each;
+
+    text = xf_init_profile_text();
+    if ((NULL == text) || ('\0' == *text)) {
+        return;
+    }
+    XF_LOGD(TAG, "profile: %s", text);
+
+    for_each(xf_init_profile_check_rules, (void *)text);
+    /* 依赖可能成链, 反复传播直到不再变化 */
+    do {
+        s_changed = false;
+        for_each(xf_init_profile_check_deps, (void *)text);
+    } while (s_changed);
+
+    XF_LOGI(TAG, "%u init functions skipped by profile.", (unsigned)s_skipped_count);
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static const char *xf_init_profile_text(void)
+{
+    if (s_profile_user) {
+        return s_profile_user;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    const char *env = getenv(XF_INIT_PROFILE_ENV);
+    if (env) {
+        return env;
+    }
+#endif
+#if defined(XF_INIT_PROFILE_DEFAULT)
+    return XF_INIT_PROFILE_DEFAULT;
+#else
+    return NULL;
+#endif
+}
+
+/* 取下一行, 去掉注释; ';' 视为换行 */
+static bool xf_init_profile_next_line(const char **pp_text, xf_init_profile_span_t *p_line)
+{
+    const char *p = *pp_text;
+    if ((NULL == p) || ('\0' == *p)) {
+        return false;
+    }
+    p_line->p = p;
+    while (*p && (*p != '\n') && (*p != ';')) {
+        p++;
+    }
+    p_line->len = (size_t)(p - p_line->p);
+    *pp_text = (*p) ? (p + 1) : p;
+
+    const char *comment = memchr(p_line->p, '#', p_line->len);
+    if (comment) {
+        p_line->len = (size_t)(comment - p_line->p);
+    }
+    return true;
+}
+
+static bool xf_init_profile_next_token(xf_init_profile_span_t *p_line, xf_init_profile_span_t *p_token)
+{
+    const char *p = p_line->p;
+    const char *end = p_line->p + p_line->len;
+    while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == ','))) {
+        p++;
+    }
+    if (p == end) {
+        return false;
+    }
+    p_token->p = p;
+    while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != ',')) {
+        p++;
+    }
+    p_token->len = (size_t)(p - p_token->p);
+    p_line->len -= (size_t)(p - p_line->p);
+    p_line->p = p;
+    return true;
+}
+
+static bool xf_init_profile_glob(const char *pattern, size_t len, const char *str)
+{
+    while (len > 0) {
+        if (*pattern == '*') {
+            /* 连续的 '*' 等价于一个 */
+            while ((len > 0) && (*pattern == '*')) {
+                pattern++;
+                len--;
+            }
+            if (len == 0) {
+                return true;
+            }
+            for (; *str; str++) {
+                if (xf_init_profile_glob(pattern, len, str)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (('\0' == *str) || ((*pattern != '?') && (*pattern != *str))) {
+            return false;
+        }
+        pattern++;
+        len--;
+        str++;
+    }
+    return '\0' == *str;
+}
+
+static int xf_init_profile_level(const xf_init_profile_span_t *p_name)
+{
+    for (int level = XF_INIT_LEVEL_SETUP; level <= XF_INIT_LEVEL_APP; level++) {
+        if ((strlen(s_level_name[level]) == p_name->len)
+                && (strncmp(s_level_name[level], p_name->p, p_name->len) == 0)) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+/* level 为 0 表示不限等级 (仅按名字查询时) */
+static bool xf_init_profile_rules_match(const char *text, const char *func_name, uint8_t level)
+{
+    xf_init_profile_span_t line;
+    xf_init_profile_span_t token;
+    bool enabled = true;
+
+    while (xf_init_profile_next_line(&text, &line)) {
+        while (xf_init_profile_next_token(&line, &token)) {
+            if ((token.p[0] != '+') && (token.p[0] != '-')) {
+                break;      /* 依赖行 */
+            }
+            xf_init_profile_span_t pattern = { token.p + 1, token.len - 1 };
+            const char *colon = memchr(pattern.p, ':', pattern.len);
+            if (colon) {
+                xf_init_profile_span_t level_name = { pattern.p, (size_t)(colon - pattern.p) };
+                int rule_level = xf_init_profile_level(&level_name);
+                if (rule_level < 0) {
+                    XF_LOGW(TAG, "unknown level in rule: %.*s", (int)token.len, token.p);
+                    continue;
+                }
+                if ((level != 0) && (rule_level != level)) {
+                    continue;
+                }
+                pattern.len -= (size_t)(colon + 1 - pattern.p);
+                pattern.p = colon + 1;
+            }
+            if (xf_init_profile_glob(pattern.p, pattern.len, func_name)) {
+                enabled = (token.p[0] == '+');
+            }
+        }
+    }
+    return enabled;
+}
+
+/* 若 line 为 "func_name: deps..." 则返回 true, 并取出依赖部分 */
+static bool xf_init_profile_dep_line(xf_init_profile_span_t line, const char *func_name,
+                                     xf_init_profile_span_t *p_deps)
+{
+    xf_init_profile_span_t head;
+    xf_init_profile_span_t name;
+    const char *colon = memchr(line.p, ':', line.len);
+    if (NULL == colon) {
+        return false;
+    }
+    head.p = line.p;
+    head.len = (size_t)(colon - line.p);
+    if (!xf_init_profile_next_token(&head, &name)) {
+        return false;
+    }
+    if ((name.p[0] == '+') || (name.p[0] == '-')) {
+        return false;
+    }
+    if ((strlen(func_name) != name.len) || (strncmp(func_name, name.p, name.len) != 0)) {
+        return false;
+    }
+    p_deps->p = colon + 1;
+    p_deps->len = line.len - (size_t)(colon + 1 - line.p);
+    return true;
+}
+
+static bool xf_init_profile_check_rules(size_t index, const char *func_name, uint8_t level, void *user_data)
+{
+    if (index >= XF_INIT_PROFILE_MAX_ENTRIES) {
+        XF_LOGW(TAG, "more than %u init functions, the rest always run.", (unsigned)XF_INIT_PROFILE_MAX_ENTRIES);
+        return false;
+    }
+    if (!xf_init_profile_rules_match((const char *)user_data, func_name, level)) {
+        XF_LOGD(TAG, "skip %s.", func_name);
+        xf_init_profile_mark(index);
+    }
+    return true;
+}
+
+static bool xf_init_profile_check_deps(size_t index, const char *func_name, uint8_t level, void *user_data)
+{
+    const char *text = (const char *)user_data;
+    xf_init_profile_span_t line;
+    xf_init_profile_span_t deps;
+    xf_init_profile_span_t dep;
+
+    UNUSED(level);
+    if ((index >= XF_INIT_PROFILE_MAX_ENTRIES) || xf_init_profile_skipped(index)) {
+        return index < XF_INIT_PROFILE_MAX_ENTRIES;
+    }
+    while (xf_init_profile_next_line(&text, &line)) {
+        if (!xf_init_profile_dep_line(line, func_name, &deps)) {
+            continue;
+        }
+        while (xf_init_profile_next_token(&deps, &dep)) {
+            xf_init_profile_find_t find = { .name = dep };
+            s_for_each(xf_init_profile_find, &find);
+            if (!find.found || find.skipped) {
+                XF_LOGD(TAG, "skip %s: %.*s unavailable.", func_name, (int)dep.len, dep.p);
+                xf_init_profile_mark(index);
+                s_changed = true;
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+static bool xf_init_profile_find(size_t index, const char *func_name, uint8_t level, void *user_data)
+{
+    xf_init_profile_find_t *p_find = (xf_init_profile_find_t *)user_data;
+    UNUSED(level);
+    if ((strlen(func_name) != p_find->name.len) || (strncmp(func_name, p_find->name.p, p_find->name.len) != 0)) {
+        return true;
+    }
+    p_find->found = true;
+    p_find->skipped = xf_init_profile_skipped(index);
+    return false;
+}
+
+static void xf_init_profile_mark(size_t index)
+{
+    xf_init_profile_bitmap[index >> 5] |= 1u << (index & 31);
+    s_skipped_count++;
+}
+
+#endif /* XF_INIT_ENABLE_PROFILE */
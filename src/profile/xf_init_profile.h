@@ -0,0 +1,128 @@
+/**
+ * @file xf_init_profile.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 启动 profile：运行时按规则跳过部分初始化函数。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_PROFILE_H__
+#define __XF_INIT_PROFILE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_PROFILE || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_profile profile
+ * @brief 同一个镜像按部署角色只执行需要的初始化函数。需要开启 `XF_INIT_ENABLE_PROFILE`.
+ *
+ * profile 为多行文本, `;` 与换行等价, `#` 之后为注释:
+ * - 规则行: 以 `+` (执行) 或 `-` (跳过) 开头的若干规则, 以空格或 `,` 分隔.
+ *   规则为 `[LEVEL:]pattern`, pattern 匹配函数名, 支持 `*` 与 `?`, LEVEL 如 `DEVICE`;
+ *   所有规则按顺序匹配, 最后一条匹配的规则生效, 没有匹配的规则时执行;
+ * - 依赖行: `name: dep1 dep2`, 任意一个依赖被跳过 (或不存在) 时 name 也被跳过.
+ *
+ * 例如只保留网络相关组件: `-COMPONENT:* +COMPONENT:net_*; net_mqtt: net_tcp`.
+ *
+ * profile 的来源依次为 @ref xf_init_profile_set / @ref xf_init_profile_load,
+ * 环境变量 `XF_INIT_PROFILE_ENV` (POSIX), 编译期的 `XF_INIT_PROFILE_DEFAULT`.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 指定 profile 文本. 需要在 @ref xf_init 之前调用.
+ *
+ * @param text profile 文本, 只保存指针, 需保证之后一直有效. NULL 表示清除.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      profile 已经求值
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_profile_set(const char *text);
+
+/**
+ * @brief 从文件加载 profile. 需要在 @ref xf_init 之前调用.
+ *
+ * @param path 文件路径.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      profile 已经求值
+ *      - XF_ERR_NOT_FOUND          文件无法打开
+ *      - XF_ERR_INVALID_SIZE       文件超过 `XF_INIT_PROFILE_TEXT_SIZE`
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_profile_load(const char *path);
+
+/**
+ * @brief 查询某个初始化函数在当前 profile 下是否会执行.
+ *
+ * 可用于依赖方在运行时判断可选功能是否可用.
+ *
+ * @param func_name 函数名.
+ * @return true 会执行 (或已执行).
+ * @return false 被跳过或不存在.
+ */
+bool xf_init_profile_is_enabled(const char *func_name);
+
+/**
+ * @brief 获取被跳过的初始化函数个数.
+ *
+ * @return size_t 个数, profile 尚未求值时为 0.
+ */
+size_t xf_init_profile_skipped_count(void);
+
+/**
+ * @brief （内部函数）对 profile 求值一次, 生成位图. 重复调用直接返回.
+ *
+ * @param for_each 当前实现方式的遍历函数.
+ */
+void xf_init_profile_prepare(xf_init_dispatch_for_each_t for_each);
+
+/**
+ * @brief （内部使用）跳过位图, 第 index 位为 1 表示跳过.
+ */
+extern uint32_t xf_init_profile_bitmap[(XF_INIT_PROFILE_MAX_ENTRIES + 31) / 32];
+
+/**
+ * @brief （内部函数）第 index 个初始化函数是否被跳过, 只需一次位测试.
+ *
+ * @param index 序号, 与执行顺序一致.
+ * @return true 跳过.
+ */
+static inline bool xf_init_profile_skipped(size_t index)
+{
+    return (index < XF_INIT_PROFILE_MAX_ENTRIES)
+           && (xf_init_profile_bitmap[index >> 5] & (1u << (index & 31)));
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_profile
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_PROFILE */
+
+#endif /* __XF_INIT_PROFILE_H__ */
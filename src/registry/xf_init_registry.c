@@ -12,6 +12,8 @@
 /* ==================== [Includes] ========================================== */
 
 #include "xf_init_registry.h"
+#include "../profile/xf_init_profile.h"
+#include "../warmup/xf_init_warmup.h"
 
 #if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR
 
@@ -21,69 +23,484 @@
 
 /* ==================== [Typedefs] ========================================== */
 
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+/**
+ * @brief 挂起 / 恢复静态表条目, 一个阶段一张表, 按注册表顺序排列.
+ */
+typedef struct _xf_init_registry_stage_entry_t {
+    uint8_t type;
+    const xf_init_registry_desc_t *p_desc;
+} xf_init_registry_stage_entry_t;
+#endif
+
+/**
+ * @brief 按阶段执行时攒批用.
+ */
+typedef struct _xf_init_registry_batch_t {
+    xf_init_dispatch_job_t jobs[XF_INIT_PARALLEL_BATCH];
+    size_t count;
+    int result;
+    bool parallel;
+} xf_init_registry_batch_t;
+
 /* ==================== [Static Prototypes] ================================= */
 
-#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && !XF_INIT_REGISTRY_STATIC_TABLE
 static void xf_init_explicit_call_registry(void);
 #endif
 
+static int xf_init_registry_suspend_level(xf_init_registry_type_t type);
+static int xf_init_registry_stage_level(xf_init_stage_t stage, xf_init_registry_type_t type, bool parallel);
+static void xf_init_registry_batch_add(xf_init_registry_batch_t *p_batch, xf_init_stage_t stage,
+                                       const xf_init_registry_desc_t *p_desc, xf_init_registry_type_t type);
+static void xf_init_registry_batch_flush(xf_init_registry_batch_t *p_batch);
+
 /* ==================== [Static Variables] ================================== */
 
-static xf_list_t s_init_head[XF_INIT_REGISTRY_TYPE_MAX] = {
-    [XF_INIT_REGISTRY_TYPE_SETUP]        = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_SETUP]),
-    [XF_INIT_REGISTRY_TYPE_BOARD]        = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_BOARD]),
-    [XF_INIT_REGISTRY_TYPE_PREV]         = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_PREV]),
-    [XF_INIT_REGISTRY_TYPE_CLEANUP]      = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_CLEANUP]),
-    [XF_INIT_REGISTRY_TYPE_DEVICE]       = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_DEVICE]),
-    [XF_INIT_REGISTRY_TYPE_COMPONENT]    = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_COMPONENT]),
-    [XF_INIT_REGISTRY_TYPE_ENV]          = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_ENV]),
-    [XF_INIT_REGISTRY_TYPE_APP]          = XF_LIST_HEAD_INIT(s_init_head[XF_INIT_REGISTRY_TYPE_APP]),
+#define XF_INIT_REGISTRY_HEADS_INIT(stage) { \
+    [XF_INIT_REGISTRY_TYPE_SETUP]        = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_SETUP]), \
+    [XF_INIT_REGISTRY_TYPE_BOARD]        = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_BOARD]), \
+    [XF_INIT_REGISTRY_TYPE_PREV]         = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_PREV]), \
+    [XF_INIT_REGISTRY_TYPE_CLEANUP]      = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_CLEANUP]), \
+    [XF_INIT_REGISTRY_TYPE_DEVICE]       = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_DEVICE]), \
+    [XF_INIT_REGISTRY_TYPE_COMPONENT]    = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_COMPONENT]), \
+    [XF_INIT_REGISTRY_TYPE_ENV]          = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_ENV]), \
+    [XF_INIT_REGISTRY_TYPE_APP]          = XF_LIST_HEAD_INIT(s_init_head[stage][XF_INIT_REGISTRY_TYPE_APP]), \
+}
+
+static xf_list_t s_init_head[XF_INIT_STAGE_MAX][XF_INIT_REGISTRY_TYPE_MAX] = {
+    [XF_INIT_STAGE_INIT]        = XF_INIT_REGISTRY_HEADS_INIT(XF_INIT_STAGE_INIT),
+    [XF_INIT_STAGE_SUSPEND]     = XF_INIT_REGISTRY_HEADS_INIT(XF_INIT_STAGE_SUSPEND),
+    [XF_INIT_STAGE_RESUME]      = XF_INIT_REGISTRY_HEADS_INIT(XF_INIT_STAGE_RESUME),
+    [XF_INIT_STAGE_POSTFORK]    = XF_INIT_REGISTRY_HEADS_INIT(XF_INIT_STAGE_POSTFORK),
+    [XF_INIT_STAGE_WARMUP]      = XF_INIT_REGISTRY_HEADS_INIT(XF_INIT_STAGE_WARMUP),
+};
+#define s_head(x) s_init_head[XF_INIT_STAGE_INIT][x]
+#define s_stage_head(stage, x) s_init_head[stage][x]
+
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+
+#define XF_INIT_REGISTRY_ACTION_DECLARE
+#include "xf_init_registry_rule.h"
+
+/* 每个等级一张以 NULL 结尾的常量表, 编译期由注册表生成 */
+static const xf_init_registry_desc_t *const s_init_table_setup[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_SETUP(p_desc)        p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_board[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_BOARD(p_desc)        p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_prev[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_PREV(p_desc)         p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_cleanup[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_CLEANUP(p_desc)      p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_device[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_DEVICE(p_desc)       p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_component[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_COMPONENT(p_desc)    p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_env[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_ENV(p_desc)          p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+static const xf_init_registry_desc_t *const s_init_table_app[] __xf_initconst = {
+#define XF_INIT_REGISTRY_TABLE_APP(p_desc)          p_desc,
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    NULL,
+};
+
+static const xf_init_registry_desc_t *const *const s_init_table[XF_INIT_REGISTRY_TYPE_MAX] = {
+    [XF_INIT_REGISTRY_TYPE_SETUP]        = s_init_table_setup,
+    [XF_INIT_REGISTRY_TYPE_BOARD]        = s_init_table_board,
+    [XF_INIT_REGISTRY_TYPE_PREV]         = s_init_table_prev,
+    [XF_INIT_REGISTRY_TYPE_CLEANUP]      = s_init_table_cleanup,
+    [XF_INIT_REGISTRY_TYPE_DEVICE]       = s_init_table_device,
+    [XF_INIT_REGISTRY_TYPE_COMPONENT]    = s_init_table_component,
+    [XF_INIT_REGISTRY_TYPE_ENV]          = s_init_table_env,
+    [XF_INIT_REGISTRY_TYPE_APP]          = s_init_table_app,
+};
+
+static const xf_init_registry_stage_entry_t s_suspend_table[] = {
+#define XF_INIT_REGISTRY_TABLE_SUSPEND(p_desc, type)    { (type), (p_desc) },
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    { XF_INIT_REGISTRY_TYPE_MAX, NULL },
+};
+static const xf_init_registry_stage_entry_t s_resume_table[] = {
+#define XF_INIT_REGISTRY_TABLE_RESUME(p_desc, type)     { (type), (p_desc) },
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    { XF_INIT_REGISTRY_TYPE_MAX, NULL },
+};
+static const xf_init_registry_stage_entry_t s_postfork_table[] = {
+#define XF_INIT_REGISTRY_TABLE_POSTFORK(p_desc, type)   { (type), (p_desc) },
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    { XF_INIT_REGISTRY_TYPE_MAX, NULL },
+};
+static const xf_init_registry_stage_entry_t s_warmup_table[] = {
+#define XF_INIT_REGISTRY_TABLE_WARMUP(p_desc, type)     { (type), (p_desc) },
+#define XF_INIT_REGISTRY_ACTION_TABLE
+#include "xf_init_registry_rule.h"
+    { XF_INIT_REGISTRY_TYPE_MAX, NULL },
+};
+
+static const xf_init_registry_stage_entry_t *const s_stage_table[XF_INIT_STAGE_MAX] = {
+    [XF_INIT_STAGE_SUSPEND]     = s_suspend_table,
+    [XF_INIT_STAGE_RESUME]      = s_resume_table,
+    [XF_INIT_STAGE_POSTFORK]    = s_postfork_table,
+    [XF_INIT_STAGE_WARMUP]      = s_warmup_table,
 };
-#define s_head(x) s_init_head[x]
+
+#endif
+
+/* 初始化函数的描述符已回收 */
+static bool s_released = false;
+
+#if XF_INIT_REGISTRY_CPP_TABLE
+/* 没有 C++ 导出时链接器不生成这两个符号, 弱引用为 NULL */
+extern const xf_init_registry_cpp_entry_t __start_xf_init_cpp[] __attribute__((weak));
+extern const xf_init_registry_cpp_entry_t __stop_xf_init_cpp[] __attribute__((weak));
+#endif
 
 /* ==================== [Macros] ============================================ */
 
+#if XF_INIT_ENABLE_PROFILE
+#   define xf_init_registry_skipped(index)     xf_init_profile_skipped(index)
+#else
+#   define xf_init_registry_skipped(index)     false
+#endif
+
 /* ==================== [Global Functions] ================================== */
 
 void xf_init_registry_register_desc_node(xf_init_registry_desc_node_t *p_desc_node, xf_init_registry_type_t type)
 {
-    if (unlikely((NULL == s_head(type).prev)
-                 || (NULL == s_head(type).next))) {
-        xf_list_init(&s_head(type));
+    xf_init_registry_register_stage_desc_node(p_desc_node, XF_INIT_STAGE_INIT, type);
+}
+
+void xf_init_registry_register_stage_desc_node(xf_init_registry_desc_node_t *p_desc_node,
+        xf_init_stage_t stage, xf_init_registry_type_t type)
+{
+    if (unlikely((NULL == s_stage_head(stage, type).prev)
+                 || (NULL == s_stage_head(stage, type).next))) {
+        xf_list_init(&s_stage_head(stage, type));
     }
     if (unlikely((NULL == p_desc_node->node.prev)
                  || (NULL == p_desc_node->node.next))) {
         xf_list_init(&p_desc_node->node);
     }
-    xf_list_add_tail(&p_desc_node->node, &s_head(type));
+    xf_list_add_tail(&p_desc_node->node, &s_stage_head(stage, type));
 }
 
 void xf_init_from_registry(void)
+{
+    xf_init_levels_from_registry(XF_INIT_LEVEL_SETUP, XF_INIT_LEVEL_APP);
+}
+
+void xf_init_levels_from_registry(uint8_t first, uint8_t last)
 {
     xf_init_registry_type_t init_type;
-    int result = 0;
-    UNUSED(result);
     xf_init_registry_desc_node_t *p_desc_node = NULL;
+    xf_init_registry_batch_t batch = { .parallel = XF_INIT_ENABLE_PARALLEL_INIT };
+    size_t index = 0;
+
+    if (s_released) {
+        return;
+    }
 
-#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && !XF_INIT_REGISTRY_STATIC_TABLE
     xf_init_explicit_call_registry();
 #endif
+#if XF_INIT_ENABLE_PROFILE
+    xf_init_profile_prepare(xf_init_registry_for_each);
+#endif
+
+    /* 序号需与 xf_init_registry_for_each 一致, 因此低于 first 的等级也要计数 */
+    for (init_type = XF_INIT_REGISTRY_TYPE_SETUP;
+            (init_type < XF_INIT_REGISTRY_TYPE_MAX) && (init_type < last); ++init_type) {
+        bool run = (init_type >= (xf_init_registry_type_t)(first - 1));
+        if (run) {
+            xf_init_dispatch_level_done((uint8_t)init_type);
+        }
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+        const xf_init_registry_desc_t *const *pp_desc = s_init_table[init_type];
+        for (; *pp_desc; pp_desc++, index++) {
+            if (run && !xf_init_registry_skipped(index)) {
+                xf_init_registry_batch_add(&batch, XF_INIT_STAGE_INIT, *pp_desc, init_type);
+            }
+        }
+#endif
+        /* 静态表模式下链表只剩非 ELF 工具链上 C++ 静态初始化注册的条目 */
+        xf_list_for_each_entry(p_desc_node, &s_head(init_type), xf_init_registry_desc_node_t, node) {
+            if ((p_desc_node) && (p_desc_node->p_desc)) {
+                if (run && !xf_init_registry_skipped(index)) {
+                    xf_init_registry_batch_add(&batch, XF_INIT_STAGE_INIT, p_desc_node->p_desc, init_type);
+                }
+                index++;
+            }
+        }
+#if XF_INIT_REGISTRY_CPP_TABLE
+        const xf_init_registry_cpp_entry_t *p_entry = __start_xf_init_cpp;
+        for (; p_entry < __stop_xf_init_cpp; p_entry++) {
+            if (p_entry->type != (uintptr_t)init_type) {
+                continue;
+            }
+            if (run && !xf_init_registry_skipped(index)) {
+                xf_init_registry_batch_add(&batch, XF_INIT_STAGE_INIT, p_entry->p_desc, init_type);
+            }
+            index++;
+        }
+#endif
+        /* 等级之间按顺序执行 */
+        xf_init_registry_batch_flush(&batch);
+    }
+    xf_init_dispatch_level_done(last);
+}
+
+void xf_init_registry_for_each(xf_init_dispatch_entry_cb_t cb, void *user_data)
+{
+    xf_init_registry_type_t init_type;
+    xf_init_registry_desc_node_t *p_desc_node = NULL;
+    size_t index = 0;
+
+    if (s_released) {
+        return;
+    }
 
     for (init_type = XF_INIT_REGISTRY_TYPE_SETUP; init_type < XF_INIT_REGISTRY_TYPE_MAX; ++init_type) {
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+        const xf_init_registry_desc_t *const *pp_desc = s_init_table[init_type];
+        for (; *pp_desc; pp_desc++) {
+            if (!cb(index++, (*pp_desc)->func_name, (uint8_t)(init_type + 1), user_data)) {
+                return;
+            }
+        }
+#endif
         xf_list_for_each_entry(p_desc_node, &s_head(init_type), xf_init_registry_desc_node_t, node) {
-            if ((p_desc_node) && (p_desc_node->p_desc) && (p_desc_node->p_desc->func)) {
-                result = p_desc_node->p_desc->func();
-                XF_LOGD(TAG, "initialize [ret: %d] %s done.", result, p_desc_node->p_desc->func_name);
+            if ((p_desc_node) && (p_desc_node->p_desc)) {
+                if (!cb(index++, p_desc_node->p_desc->func_name, (uint8_t)(init_type + 1), user_data)) {
+                    return;
+                }
+            }
+        }
+#if XF_INIT_REGISTRY_CPP_TABLE
+        const xf_init_registry_cpp_entry_t *p_entry = __start_xf_init_cpp;
+        for (; p_entry < __stop_xf_init_cpp; p_entry++) {
+            if ((p_entry->type == (uintptr_t)init_type)
+                    && !cb(index++, p_entry->p_desc->func_name, (uint8_t)(init_type + 1), user_data)) {
+                return;
             }
         }
+#endif
     }
 }
 
+xf_err_t xf_init_suspend_from_registry(void)
+{
+    int init_type;
+    for (init_type = XF_INIT_REGISTRY_TYPE_MAX - 1; init_type >= XF_INIT_REGISTRY_TYPE_SETUP; --init_type) {
+        if (xf_init_registry_suspend_level((xf_init_registry_type_t)init_type) != 0) {
+            return XF_FAIL;
+        }
+    }
+    return XF_OK;
+}
+
+xf_err_t xf_init_resume_from_registry(void)
+{
+    xf_init_registry_type_t init_type;
+    int result = 0;
+    for (init_type = XF_INIT_REGISTRY_TYPE_SETUP; init_type < XF_INIT_REGISTRY_TYPE_MAX; ++init_type) {
+        if (xf_init_registry_stage_level(XF_INIT_STAGE_RESUME, init_type, XF_INIT_ENABLE_PARALLEL_RESUME) != 0) {
+            result = -1;
+        }
+    }
+    return (result == 0) ? XF_OK : XF_FAIL;
+}
+
+xf_err_t xf_init_postfork_from_registry(void)
+{
+    xf_init_registry_type_t init_type;
+    int result = 0;
+    for (init_type = XF_INIT_REGISTRY_TYPE_SETUP; init_type < XF_INIT_REGISTRY_TYPE_MAX; ++init_type) {
+        if (xf_init_registry_stage_level(XF_INIT_STAGE_POSTFORK, init_type, false) != 0) {
+            result = -1;
+        }
+    }
+    return (result == 0) ? XF_OK : XF_FAIL;
+}
+
+#if XF_INIT_ENABLE_WARMUP
+void xf_init_warmup_from_registry(void)
+{
+    xf_init_registry_desc_node_t *p_desc_node = NULL;
+    const xf_init_registry_desc_t *p_desc = NULL;
+    const xf_init_registry_type_t type = XF_INIT_REGISTRY_TYPE_APP;
+
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+    const xf_init_registry_stage_entry_t *p_entry = s_warmup_table;
+    for (; p_entry->p_desc; p_entry++) {
+        p_desc = p_entry->p_desc;
+        if ((NULL != p_desc->func)
+                && !xf_init_warmup_call((uint8_t)(p_entry->type + 1), p_desc->func, p_desc->func_name)) {
+            return;
+        }
+    }
+#endif
+    xf_list_for_each_entry(p_desc_node, &s_stage_head(XF_INIT_STAGE_WARMUP, type),
+                           xf_init_registry_desc_node_t, node) {
+        p_desc = p_desc_node->p_desc;
+        if ((NULL != p_desc) && (NULL != p_desc->func)
+                && !xf_init_warmup_call((uint8_t)(type + 1), p_desc->func, p_desc->func_name)) {
+            return;
+        }
+    }
+}
+#endif
+
+void xf_init_registry_release(void)
+{
+    xf_init_registry_type_t init_type;
+
+    /* 节点本身可能位于已回收的页, 只重置链表头, 不逐个摘除 */
+    for (init_type = XF_INIT_REGISTRY_TYPE_SETUP; init_type < XF_INIT_REGISTRY_TYPE_MAX; ++init_type) {
+        xf_list_init(&s_head(init_type));
+    }
+    s_released = true;
+}
+
 /* ==================== [Static Functions] ================================== */
 
-#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY
+/* 挂起顺序与恢复顺序相反: 先链表后静态表, 各自倒序 */
+static int xf_init_registry_suspend_level(xf_init_registry_type_t type)
+{
+    xf_init_registry_desc_node_t *p_desc_node = NULL;
+    const xf_init_registry_desc_t *p_desc = NULL;
+
+    xf_list_for_each_entry_reverse(p_desc_node, &s_stage_head(XF_INIT_STAGE_SUSPEND, type),
+                                   xf_init_registry_desc_node_t, node) {
+        p_desc = p_desc_node->p_desc;
+        if ((NULL == p_desc) || (NULL == p_desc->func)) {
+            continue;
+        }
+        if (xf_init_dispatch_call(XF_INIT_STAGE_SUSPEND, (uint8_t)(type + 1), p_desc->func, p_desc->func_name) != 0) {
+            XF_LOGE(TAG, "suspend %s failed, abort.", p_desc->func_name);
+            return -1;
+        }
+    }
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+    size_t i;
+    for (i = ARRAY_SIZE(s_suspend_table) - 1; i > 0; i--) {
+        const xf_init_registry_stage_entry_t *p_entry = &s_suspend_table[i - 1];
+        if ((p_entry->type != type) || (NULL == p_entry->p_desc->func)) {
+            continue;
+        }
+        p_desc = p_entry->p_desc;
+        if (xf_init_dispatch_call(XF_INIT_STAGE_SUSPEND, (uint8_t)(type + 1), p_desc->func, p_desc->func_name) != 0) {
+            XF_LOGE(TAG, "suspend %s failed, abort.", p_desc->func_name);
+            return -1;
+        }
+    }
+#endif
+    return 0;
+}
+
+/* 按注册顺序执行某一阶段某一等级的函数, 失败不中断; parallel 时攒成一批并发执行 */
+static int xf_init_registry_stage_level(xf_init_stage_t stage, xf_init_registry_type_t type, bool parallel)
+{
+    xf_init_registry_batch_t batch = {0};
+    xf_init_registry_desc_node_t *p_desc_node = NULL;
+
+    batch.parallel = parallel;
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && XF_INIT_REGISTRY_STATIC_TABLE
+    const xf_init_registry_stage_entry_t *p_entry = s_stage_table[stage];
+    for (; p_entry->p_desc; p_entry++) {
+        if (p_entry->type == type) {
+            xf_init_registry_batch_add(&batch, stage, p_entry->p_desc, type);
+        }
+    }
+#endif
+    xf_list_for_each_entry(p_desc_node, &s_stage_head(stage, type),
+                           xf_init_registry_desc_node_t, node) {
+        if (p_desc_node->p_desc) {
+            xf_init_registry_batch_add(&batch, stage, p_desc_node->p_desc, type);
+        }
+    }
+    xf_init_registry_batch_flush(&batch);
+    return batch.result;
+}
+
+static void xf_init_registry_batch_add(xf_init_registry_batch_t *p_batch, xf_init_stage_t stage,
+                                       const xf_init_registry_desc_t *p_desc, xf_init_registry_type_t type)
+{
+    if (NULL == p_desc->func) {
+        return;
+    }
+    if (!p_batch->parallel) {
+        if (xf_init_dispatch_call(stage, (uint8_t)(type + 1), p_desc->func, p_desc->func_name) != 0) {
+            p_batch->result = -1;
+        }
+        return;
+    }
+    if (p_batch->count == XF_INIT_PARALLEL_BATCH) {
+        xf_init_registry_batch_flush(p_batch);
+    }
+    p_batch->jobs[p_batch->count++] = (xf_init_dispatch_job_t) {
+        .func       = p_desc->func,
+        .func_name  = p_desc->func_name,
+        .stage      = (uint8_t)stage,
+        .level      = (uint8_t)(type + 1),
+#if XF_INIT_ENABLE_RESOURCE
+        .resource   = p_desc->resource,
+#endif
+    };
+}
+
+static void xf_init_registry_batch_flush(xf_init_registry_batch_t *p_batch)
+{
+    if (0 == p_batch->count) {
+        return;
+    }
+    if (xf_init_dispatch_parallel(p_batch->jobs, p_batch->count) != 0) {
+        p_batch->result = -1;
+    }
+    p_batch->count = 0;
+}
+
+#if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY && !XF_INIT_REGISTRY_STATIC_TABLE
+/* 分阶段初始化时会被多次调用, 注册只能进行一次 */
 static void xf_init_explicit_call_registry(void)
 {
+    static bool s_registered = false;
+    if (s_registered) {
+        return;
+    }
+    s_registered = true;
+
 #define XF_INIT_REGISTRY_ACTION_DECLARE
 #include "xf_init_registry_rule.h"
 #define XF_INIT_REGISTRY_ACTION_CALL
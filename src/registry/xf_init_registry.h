@@ -15,6 +15,8 @@
 /* ==================== [Includes] ========================================== */
 
 #include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "../release/xf_init_release.h"
 #include "xf_utils.h"
 
 #if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY) \
@@ -42,6 +44,22 @@ extern "C" {
 #   define __constructor
 #endif
 
+#define XF_INIT_REGISTRY_STAGE_suspend      XF_INIT_STAGE_SUSPEND
+#define XF_INIT_REGISTRY_STAGE_resume       XF_INIT_STAGE_RESUME
+#define XF_INIT_REGISTRY_STAGE_postfork     XF_INIT_STAGE_POSTFORK
+#define XF_INIT_REGISTRY_STAGE_warmup       XF_INIT_STAGE_WARMUP
+
+/*
+ * ELF 上 C++ 导出的初始化函数在编译期写入 XF_INIT_REGISTRY_CPP_SECTION 段,
+ * 由链接器生成的 __start_ / __stop_ 符号界定, 不需要运行时注册.
+ */
+#if defined(__GNUC__) && defined(__ELF__)
+#   define XF_INIT_REGISTRY_CPP_TABLE       1
+#else
+#   define XF_INIT_REGISTRY_CPP_TABLE       0
+#endif
+#define XF_INIT_REGISTRY_CPP_SECTION        "xf_init_cpp"
+
 /* ==================== [Typedefs] ========================================== */
 
 /**
@@ -79,6 +97,9 @@ typedef int (*xf_init_fn_t)(void);
 typedef struct _xf_init_registry_desc_t {
     const xf_init_fn_t func;            /*!< 初始化函数 */
     const char *func_name;              /*!< 初始化函数的函数名 */
+#if XF_INIT_ENABLE_RESOURCE
+    const char *resource;               /*!< 所需的资源令牌, 逗号分隔, 可为 NULL */
+#endif
 } xf_init_registry_desc_t;
 
 /**
@@ -91,6 +112,16 @@ typedef struct _xf_init_registry_desc_node_t {
     const xf_init_registry_desc_t *const p_desc;
 } xf_init_registry_desc_node_t;
 
+/**
+ * @brief C++ 导出的初始化函数表项, 见 XF_INIT_REGISTRY_CPP_TABLE.
+ *
+ * @note 由 xf_init.hpp 用汇编写入, 布局改动时需同步修改.
+ */
+typedef struct _xf_init_registry_cpp_entry_t {
+    const xf_init_registry_desc_t *p_desc;  /*!< 描述符 */
+    uintptr_t type;                         /*!< 等级, 见 @ref xf_init_registry_type_t */
+} xf_init_registry_cpp_entry_t;
+
 /* ==================== [Global Prototypes] ================================= */
 
 /**
@@ -101,26 +132,183 @@ typedef struct _xf_init_registry_desc_node_t {
  */
 void xf_init_registry_register_desc_node(xf_init_registry_desc_node_t *p_desc_node, xf_init_registry_type_t type);
 
+/**
+ * @brief （内部函数）注册挂起 / 恢复函数，无需直接调用，使用宏调用
+ *
+ * @param p_desc_node 函数详情结构体
+ * @param stage 阶段, 见 @ref xf_init_stage_t
+ * @param type 所属等级
+ */
+void xf_init_registry_register_stage_desc_node(xf_init_registry_desc_node_t *p_desc_node,
+        xf_init_stage_t stage, xf_init_registry_type_t type);
+
 /**
  * @brief 注册函数收集后，统一在此调用初始化函数
  *
  */
 void xf_init_from_registry(void);
 
+/**
+ * @brief 只调用 [first, last] 等级范围内的初始化函数.
+ *
+ * @param first 起始等级, 见 XF_INIT_LEVEL_*.
+ * @param last 结束等级 (包含).
+ */
+void xf_init_levels_from_registry(uint8_t first, uint8_t last);
+
+/**
+ * @brief 按执行顺序遍历注册的初始化函数 (每个等级内先静态表, 再链表, 最后是 C++ 表).
+ *
+ * @param cb 回调, 返回 false 时停止.
+ * @param user_data 用户数据.
+ */
+void xf_init_registry_for_each(xf_init_dispatch_entry_cb_t cb, void *user_data);
+
+/**
+ * @brief 按等级从高到低调用挂起函数, 遇到失败时停止.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个挂起函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_suspend_from_registry(void);
+
+/**
+ * @brief 按等级从低到高调用恢复函数.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个恢复函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_resume_from_registry(void);
+
+/**
+ * @brief 按等级从低到高调用 fork 后的重新初始化函数.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_postfork_from_registry(void);
+
+/**
+ * @brief 按注册顺序调用预热函数, 由 warmup 模块决定是否继续.
+ */
+void xf_init_warmup_from_registry(void);
+
+/**
+ * @brief 初始化函数的描述符即将被回收, 清空初始化链表, 之后不再遍历初始化函数.
+ */
+void xf_init_registry_release(void);
+
 /* ==================== [Macros] ============================================ */
 
+/*
+ * 初始化函数的描述符与链表节点在 xf_init_release() 后不再使用, 放入可回收的段.
+ * 每个描述符使用单独的段名, 避免同一文件中只读与需要重定位的数据段属性冲突.
+ * 挂起 / 恢复 / fork 后重新初始化函数之后还会用到, 不做标记.
+ */
+#define XF_INIT_REGISTRY_INITCONST(function)    XF_INIT_RELEASE_SECTION(".xf_init.rodata." XSTR(function))
+#define XF_INIT_REGISTRY_INITDATA(function)     XF_INIT_RELEASE_SECTION(".xf_init.data." XSTR(function))
+
+/*
+ * 注册表引用的符号名中带有等级 (如 __xf_init_desc_DEVICE_foo / __xf_init_registry_DEVICE_foo),
+ * 注册表中的 XF_INIT_REGISTER_<LEVEL> 与源文件中的导出宏等级不一致时链接失败, 而不是悄悄换到另一个等级.
+ */
+#define XF_INIT_REGISTRY_DESC(type, function)           CONCAT(__xf_init_desc_##type##_, function)
+#define XF_INIT_REGISTRY_FUNC(type, function)           CONCAT(__xf_init_registry_##type##_, function)
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY) && XF_INIT_REGISTRY_STATIC_TABLE
+/* 描述符由注册表在编译期直接收集 */
 #define XF_INIT_EXPORT_REGISTRY(type, function) \
-    void __used __constructor __xf_init_registry_##function(void) { \
-        static const xf_init_registry_desc_t CONCAT(__xf_init_desc_, function) = { \
+    const xf_init_registry_desc_t XF_INIT_REGISTRY_DESC(type, function) XF_INIT_REGISTRY_INITCONST(function) = { \
+        .func       = (function), \
+        .func_name  = XSTR(function), \
+    }
+
+#define XF_INIT_EXPORT_REGISTRY_STAGE(stage, type, function) \
+    const xf_init_registry_desc_t __xf_init_desc_##stage##_##type##_##function = { \
+        .func       = (function), \
+        .func_name  = XSTR(function), \
+    }
+
+#define XF_INIT_EXPORT_REGISTRY_RES(type, function, res) \
+    const xf_init_registry_desc_t XF_INIT_REGISTRY_DESC(type, function) XF_INIT_REGISTRY_INITCONST(function) = { \
+        .func       = (function), \
+        .func_name  = XSTR(function), \
+        .resource   = (res), \
+    }
+#else
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY)
+/* 供不带等级的旧形式 XF_INIT_REGISTER(function) 调用, 等级以导出宏为准 */
+#define XF_INIT_REGISTRY_LEGACY(type, function) \
+    void __used __xf_init CONCAT(__xf_init_registry_, function)(void) { \
+        XF_INIT_REGISTRY_FUNC(type, function)(); \
+    }
+#else
+#define XF_INIT_REGISTRY_LEGACY(type, function)
+#endif
+
+#define XF_INIT_EXPORT_REGISTRY_STAGE(stage, type, function) \
+    void __used __constructor __xf_init_registry_##stage##_##type##_##function(void) { \
+        static const xf_init_registry_desc_t __xf_init_desc_##stage##_##function = { \
             .func       = (function), \
             .func_name  = XSTR(function), \
         };\
-        static xf_init_registry_desc_node_t CONCAT(__xf_init_desc_node_, function) = { \
+        static xf_init_registry_desc_node_t __xf_init_desc_node_##stage##_##function = { \
+            .node       = XF_LIST_HEAD_INIT(__xf_init_desc_node_##stage##_##function.node), \
+            .p_desc     = &__xf_init_desc_##stage##_##function, \
+        };\
+        xf_init_registry_register_stage_desc_node(&__xf_init_desc_node_##stage##_##function, \
+                XF_INIT_REGISTRY_STAGE_##stage, XF_INIT_REGISTRY_TYPE_##type); \
+    }
+
+#define XF_INIT_EXPORT_REGISTRY(type, function) \
+    void __used __constructor __xf_init XF_INIT_REGISTRY_FUNC(type, function)(void) { \
+        static const xf_init_registry_desc_t CONCAT(__xf_init_desc_, function) \
+            XF_INIT_REGISTRY_INITCONST(function) = { \
+            .func       = (function), \
+            .func_name  = XSTR(function), \
+        };\
+        static xf_init_registry_desc_node_t CONCAT(__xf_init_desc_node_, function) \
+            XF_INIT_REGISTRY_INITDATA(function) = { \
             .node       = XF_LIST_HEAD_INIT(CONCAT(__xf_init_desc_node_, function).node), \
             .p_desc     = &CONCAT(__xf_init_desc_, function), \
         };\
         xf_init_registry_register_desc_node(&CONCAT(__xf_init_desc_node_, function), XF_INIT_REGISTRY_TYPE_##type); \
-    }
+    } \
+    XF_INIT_REGISTRY_LEGACY(type, function)
+
+#define XF_INIT_EXPORT_REGISTRY_RES(type, function, res) \
+    void __used __constructor __xf_init XF_INIT_REGISTRY_FUNC(type, function)(void) { \
+        static const xf_init_registry_desc_t CONCAT(__xf_init_desc_, function) \
+            XF_INIT_REGISTRY_INITCONST(function) = { \
+            .func       = (function), \
+            .func_name  = XSTR(function), \
+            .resource   = (res), \
+        };\
+        static xf_init_registry_desc_node_t CONCAT(__xf_init_desc_node_, function) \
+            XF_INIT_REGISTRY_INITDATA(function) = { \
+            .node       = XF_LIST_HEAD_INIT(CONCAT(__xf_init_desc_node_, function).node), \
+            .p_desc     = &CONCAT(__xf_init_desc_, function), \
+        };\
+        xf_init_registry_register_desc_node(&CONCAT(__xf_init_desc_node_, function), XF_INIT_REGISTRY_TYPE_##type); \
+    } \
+    XF_INIT_REGISTRY_LEGACY(type, function)
+#endif
+
+#if XF_INIT_ENABLE_RESOURCE
+/**
+ * @brief 导出声明了资源令牌的初始化函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_RESOURCE.
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 DEVICE.
+ * @param res 逗号分隔的资源令牌名, 如 "i2c0".
+ */
+#define XF_INIT_EXPORT_REGISTRY_RESOURCE(function, level, res) XF_INIT_EXPORT_REGISTRY_RES(level, function, res)
+#endif
 
 /**
  * @brief 导出板级初始化函数, 全局函数实现.
@@ -194,6 +382,45 @@ void xf_init_from_registry(void);
  */
 #define XF_INIT_EXPORT_REGISTRY_APP(function) XF_INIT_EXPORT_REGISTRY(APP, function)
 
+/**
+ * @brief 导出挂起函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_SUSPEND.
+ *
+ * @param function 挂起函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_REGISTRY_SUSPEND(function, level) XF_INIT_EXPORT_REGISTRY_STAGE(suspend, level, function)
+
+/**
+ * @brief 导出恢复函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_RESUME.
+ *
+ * @param function 恢复函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_REGISTRY_RESUME(function, level) XF_INIT_EXPORT_REGISTRY_STAGE(resume, level, function)
+
+/**
+ * @brief 导出 fork 后的重新初始化函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_POSTFORK.
+ *
+ * @param function 重新初始化函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_REGISTRY_POSTFORK(function, level) XF_INIT_EXPORT_REGISTRY_STAGE(postfork, level, function)
+
+/**
+ * @brief 导出预热函数, 等级固定为 APP.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_WARMUP.
+ *
+ * @param function 预热函数.
+ */
+#define XF_INIT_EXPORT_REGISTRY_WARMUP(function) XF_INIT_EXPORT_REGISTRY_STAGE(warmup, APP, function)
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -11,6 +11,26 @@
  * @details 用法：
  * 在包含本文件前定义 `XF_INIT_REGISTRY_ACTION_DECLARE`
  * 或 `XF_INIT_REGISTRY_ACTION_CALL` 可以实现宏的复用。
+ *
+ * 开启 `XF_INIT_REGISTRY_STATIC_TABLE` 时使用 `XF_INIT_REGISTRY_ACTION_TABLE`,
+ * 并在包含前定义需要收集的等级对应的 `XF_INIT_REGISTRY_TABLE_<LEVEL>(p_desc)`,
+ * 未定义的等级在本文件内展开为空。
+ *
+ * 注册表中可用两种形式：
+ * - `XF_INIT_REGISTER(function);`：旧形式，仅链表方式可用；
+ * - `XF_INIT_REGISTER_<LEVEL>(function)`：带等级，末尾不加分号，两种方式都可用。
+ *
+ * 带等级的条目引用的符号名中含有等级（如 `__xf_init_desc_DEVICE_function`），
+ * 与源文件中导出宏的等级不一致时链接失败。
+ *
+ * 挂起 / 恢复函数使用 `XF_INIT_REGISTER_SUSPEND(function, LEVEL)` 与
+ * `XF_INIT_REGISTER_RESUME(function, LEVEL)`，fork 后的重新初始化函数使用
+ * `XF_INIT_REGISTER_POSTFORK(function, LEVEL)`，末尾同样不加分号；
+ * 静态表对应 `XF_INIT_REGISTRY_TABLE_SUSPEND(p_desc, type)`、`XF_INIT_REGISTRY_TABLE_RESUME(p_desc, type)`
+ * 与 `XF_INIT_REGISTRY_TABLE_POSTFORK(p_desc, type)`。
+ *
+ * 预热函数使用 `XF_INIT_REGISTER_WARMUP(function)`，末尾不加分号，
+ * 静态表对应 `XF_INIT_REGISTRY_TABLE_WARMUP(p_desc, type)`。
  */
 
 /* ==================== [Includes] ========================================== */
@@ -26,16 +46,109 @@
 /* ==================== [Macros] ============================================ */
 
 #undef XF_INIT_REGISTER
+#undef XF_INIT_REGISTER_SETUP
+#undef XF_INIT_REGISTER_BOARD
+#undef XF_INIT_REGISTER_PREV
+#undef XF_INIT_REGISTER_CLEANUP
+#undef XF_INIT_REGISTER_DEVICE
+#undef XF_INIT_REGISTER_COMPONENT
+#undef XF_INIT_REGISTER_ENV
+#undef XF_INIT_REGISTER_APP
+#undef XF_INIT_REGISTER_SUSPEND
+#undef XF_INIT_REGISTER_RESUME
+#undef XF_INIT_REGISTER_POSTFORK
+#undef XF_INIT_REGISTER_WARMUP
+#undef XF_INIT_REGISTRY_ENTRY
+#undef XF_INIT_REGISTRY_STAGE_ENTRY
 
-#if defined(XF_INIT_REGISTRY_ACTION_DECLARE)
+#if defined(XF_INIT_REGISTRY_ACTION_DECLARE) && XF_INIT_REGISTRY_STATIC_TABLE
+#   define XF_INIT_REGISTER(function)
+#   define XF_INIT_REGISTRY_ENTRY(type, function)    extern const xf_init_registry_desc_t __xf_init_desc_##type##_##function;
+#   define XF_INIT_REGISTRY_STAGE_ENTRY(stage, STAGE, type, function) \
+        extern const xf_init_registry_desc_t __xf_init_desc_##stage##_##type##_##function;
+#elif defined(XF_INIT_REGISTRY_ACTION_DECLARE)
 #   define XF_INIT_REGISTER(function)        extern void __xf_init_registry_##function(void)
+#   define XF_INIT_REGISTRY_ENTRY(type, function)    extern void __xf_init_registry_##type##_##function(void);
+#   define XF_INIT_REGISTRY_STAGE_ENTRY(stage, STAGE, type, function) \
+        extern void __xf_init_registry_##stage##_##type##_##function(void);
 #elif defined(XF_INIT_REGISTRY_ACTION_CALL)
 #   define XF_INIT_REGISTER(function)        __xf_init_registry_##function()
+#   define XF_INIT_REGISTRY_ENTRY(type, function)    __xf_init_registry_##type##_##function();
+#   define XF_INIT_REGISTRY_STAGE_ENTRY(stage, STAGE, type, function) \
+        __xf_init_registry_##stage##_##type##_##function();
+#elif defined(XF_INIT_REGISTRY_ACTION_TABLE)
+#   define XF_INIT_REGISTER(function)
+#   define XF_INIT_REGISTRY_ENTRY(type, function)    XF_INIT_REGISTRY_TABLE_##type(&__xf_init_desc_##type##_##function)
+#   define XF_INIT_REGISTRY_STAGE_ENTRY(stage, STAGE, type, function) \
+        XF_INIT_REGISTRY_TABLE_##STAGE(&__xf_init_desc_##stage##_##type##_##function, XF_INIT_REGISTRY_TYPE_##type)
+#   if !defined(XF_INIT_REGISTRY_TABLE_SETUP)
+#       define XF_INIT_REGISTRY_TABLE_SETUP(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_BOARD)
+#       define XF_INIT_REGISTRY_TABLE_BOARD(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_PREV)
+#       define XF_INIT_REGISTRY_TABLE_PREV(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_CLEANUP)
+#       define XF_INIT_REGISTRY_TABLE_CLEANUP(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_DEVICE)
+#       define XF_INIT_REGISTRY_TABLE_DEVICE(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_COMPONENT)
+#       define XF_INIT_REGISTRY_TABLE_COMPONENT(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_ENV)
+#       define XF_INIT_REGISTRY_TABLE_ENV(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_APP)
+#       define XF_INIT_REGISTRY_TABLE_APP(p_desc)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_SUSPEND)
+#       define XF_INIT_REGISTRY_TABLE_SUSPEND(p_desc, type)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_RESUME)
+#       define XF_INIT_REGISTRY_TABLE_RESUME(p_desc, type)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_POSTFORK)
+#       define XF_INIT_REGISTRY_TABLE_POSTFORK(p_desc, type)
+#   endif
+#   if !defined(XF_INIT_REGISTRY_TABLE_WARMUP)
+#       define XF_INIT_REGISTRY_TABLE_WARMUP(p_desc, type)
+#   endif
 #else
 #   pragma message("Please define the action.")
 #endif
 
+#define XF_INIT_REGISTER_SETUP(function)        XF_INIT_REGISTRY_ENTRY(SETUP, function)
+#define XF_INIT_REGISTER_BOARD(function)        XF_INIT_REGISTRY_ENTRY(BOARD, function)
+#define XF_INIT_REGISTER_PREV(function)         XF_INIT_REGISTRY_ENTRY(PREV, function)
+#define XF_INIT_REGISTER_CLEANUP(function)      XF_INIT_REGISTRY_ENTRY(CLEANUP, function)
+#define XF_INIT_REGISTER_DEVICE(function)       XF_INIT_REGISTRY_ENTRY(DEVICE, function)
+#define XF_INIT_REGISTER_COMPONENT(function)    XF_INIT_REGISTRY_ENTRY(COMPONENT, function)
+#define XF_INIT_REGISTER_ENV(function)          XF_INIT_REGISTRY_ENTRY(ENV, function)
+#define XF_INIT_REGISTER_APP(function)          XF_INIT_REGISTRY_ENTRY(APP, function)
+#define XF_INIT_REGISTER_SUSPEND(function, level) XF_INIT_REGISTRY_STAGE_ENTRY(suspend, SUSPEND, level, function)
+#define XF_INIT_REGISTER_RESUME(function, level)  XF_INIT_REGISTRY_STAGE_ENTRY(resume, RESUME, level, function)
+#define XF_INIT_REGISTER_POSTFORK(function, level) XF_INIT_REGISTRY_STAGE_ENTRY(postfork, POSTFORK, level, function)
+#define XF_INIT_REGISTER_WARMUP(function)       XF_INIT_REGISTRY_STAGE_ENTRY(warmup, WARMUP, APP, function)
+
 #undef XF_INIT_REGISTRY_ACTION_DECLARE
 #undef XF_INIT_REGISTRY_ACTION_CALL
+#undef XF_INIT_REGISTRY_ACTION_TABLE
 
 #include XF_INIT_USER_REGISTRY_PATH
+
+#undef XF_INIT_REGISTRY_TABLE_SETUP
+#undef XF_INIT_REGISTRY_TABLE_BOARD
+#undef XF_INIT_REGISTRY_TABLE_PREV
+#undef XF_INIT_REGISTRY_TABLE_CLEANUP
+#undef XF_INIT_REGISTRY_TABLE_DEVICE
+#undef XF_INIT_REGISTRY_TABLE_COMPONENT
+#undef XF_INIT_REGISTRY_TABLE_ENV
+#undef XF_INIT_REGISTRY_TABLE_APP
+#undef XF_INIT_REGISTRY_TABLE_SUSPEND
+#undef XF_INIT_REGISTRY_TABLE_RESUME
+#undef XF_INIT_REGISTRY_TABLE_POSTFORK
+#undef XF_INIT_REGISTRY_TABLE_WARMUP
@@ -0,0 +1,114 @@
+/**
+ * @file xf_init_release.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 只在初始化期间使用的代码与数据，初始化完成后回收。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_release.h"
+
+#if XF_INIT_ENABLE_RELEASE
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "release"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static size_t xf_init_release_range(const char *start, const char *end, const char *what, bool in_ram);
+
+/* ==================== [Static Variables] ================================== */
+
+/* 起止符号由链接脚本提供, 未使用链接脚本时为 NULL */
+#if defined(ESP_PLATFORM)
+extern char _xf_init_data_start[] __attribute__((weak));
+extern char _xf_init_data_end[] __attribute__((weak));
+#   define s_data_start     _xf_init_data_start
+#   define s_data_end       _xf_init_data_end
+#   define s_text_start     ((char *)NULL)
+#   define s_text_end       ((char *)NULL)
+#else
+extern char __xf_init_data_start[] __attribute__((weak));
+extern char __xf_init_data_end[] __attribute__((weak));
+extern char __xf_init_text_start[] __attribute__((weak));
+extern char __xf_init_text_end[] __attribute__((weak));
+#   define s_data_start     __xf_init_data_start
+#   define s_data_end       __xf_init_data_end
+#   define s_text_start     __xf_init_text_start
+#   define s_text_end       __xf_init_text_end
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+size_t xf_init_release_sections(void)
+{
+    size_t size = 0;
+
+    size += xf_init_release_range(s_data_start, s_data_end, "data", true);
+    size += xf_init_release_range(s_text_start, s_text_end, "text", false);
+
+    return size;
+}
+
+size_t xf_init_release_rodata(const void *start, const void *end)
+{
+    return xf_init_release_range((const char *)start, (const char *)end, "rodata", false);
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static size_t xf_init_release_range(const char *start, const char *end, const char *what, bool in_ram)
+{
+    if ((NULL == start) || (NULL == end) || (end <= start)) {
+        return 0;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /* 只回收完整的页, 段首尾与其他数据共用的页保留 */
+    UNUSED(in_ram);
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t first = ((uintptr_t)start + page - 1) & ~(page - 1);
+    uintptr_t last = (uintptr_t)end & ~(page - 1);
+    if (last <= first) {
+        return 0;
+    }
+#   if XF_INIT_RELEASE_UNMAP
+    if (munmap((void *)first, last - first) != 0) {
+#   else
+    if (madvise((void *)first, last - first, MADV_DONTNEED) != 0) {
+#   endif
+        XF_LOGW(TAG, "release %s [%p, %p) failed.", what, (void *)first, (void *)last);
+        return 0;
+    }
+    return (size_t)(last - first);
+#elif defined(XF_INIT_RELEASE_TO_HEAP)
+    /* 代码与只读数据位于 flash, 只有数据区可以交给堆 */
+    UNUSED(what);
+    if (!in_ram) {
+        return 0;
+    }
+    XF_INIT_RELEASE_TO_HEAP((void *)start, (size_t)(end - start));
+    return (size_t)(end - start);
+#else
+    UNUSED(what);
+    UNUSED(in_ram);
+    return 0;
+#endif
+}
+
+#endif /* XF_INIT_ENABLE_RELEASE */
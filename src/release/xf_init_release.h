@@ -0,0 +1,107 @@
+/**
+ * @file xf_init_release.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 只在初始化期间使用的代码与数据，初始化完成后回收。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_RELEASE_H__
+#define __XF_INIT_RELEASE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_release release
+ * @brief 类似 Linux 的 `__init`, 把只在初始化期间使用的代码与数据放入独立的段,
+ * 所有等级执行完后由 @ref xf_init_release 回收. 需要开启 `XF_INIT_ENABLE_RELEASE`,
+ * 并使用 linker 目录下的链接脚本 (段按页对齐, 并提供起止符号).
+ *
+ * - POSIX: madvise(MADV_DONTNEED) 释放物理页, `XF_INIT_RELEASE_UNMAP` 为 1 时直接 munmap;
+ * - MCU: 代码位于 flash, 不回收; 数据区通过 `XF_INIT_RELEASE_TO_HEAP` 交给堆.
+ *
+ * @attention 标记的函数与数据在回收后不能再被访问, 挂起 / 恢复 / fork 后重新初始化函数
+ * 以及初始化时保存下来的指针 (如回调、字符串) 不要使用这些标记.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#if XF_INIT_ENABLE_RELEASE && defined(__GNUC__)
+#   define XF_INIT_RELEASE_SECTION(name)    __attribute__((section(name)))
+#else
+#   define XF_INIT_RELEASE_SECTION(name)
+#endif
+
+#if !defined(__xf_init)
+/**
+ * @brief 只在初始化期间执行的函数, 如 `static int __xf_init board_init(void)`.
+ */
+#   define __xf_init                        XF_INIT_RELEASE_SECTION(".xf_init.text")
+#endif
+
+#if !defined(__xf_initdata)
+/**
+ * @brief 只在初始化期间读写的数据.
+ */
+#   define __xf_initdata                    XF_INIT_RELEASE_SECTION(".xf_init.data")
+#endif
+
+#if !defined(__xf_initconst)
+/**
+ * @brief 只在初始化期间读取的常量.
+ */
+#   define __xf_initconst                   XF_INIT_RELEASE_SECTION(".xf_init.rodata")
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+#if XF_INIT_ENABLE_RELEASE || defined(__DOXYGEN__)
+
+/**
+ * @brief （内部函数）回收 `__xf_init` 段, 由 @ref xf_init_release 调用.
+ *
+ * @return size_t 回收的字节数, 链接脚本未提供对应段时为 0.
+ */
+size_t xf_init_release_sections(void);
+
+/**
+ * @brief （内部函数）回收一段初始化完成后不再访问的只读数据, 如 section 模式的描述符.
+ *
+ * 只回收 [start, end) 内完整的页; MCU 上只读数据位于 flash, 不回收.
+ *
+ * @param start 起始地址.
+ * @param end 结束地址.
+ * @return size_t 回收的字节数.
+ */
+size_t xf_init_release_rodata(const void *start, const void *end);
+
+#endif /* XF_INIT_ENABLE_RELEASE */
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_release
+ * @}
+ */
+
+#endif /* __XF_INIT_RELEASE_H__ */
@@ -0,0 +1,213 @@
+/**
+ * @file xf_init_resource.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 并发初始化时限制共享资源（总线、固件加载器、磁盘等）并发数的资源令牌。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_resource.h"
+#include "../dispatch/xf_init_dispatch.h"
+
+#if XF_INIT_ENABLE_RESOURCE
+
+#include <string.h>
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "resource"
+
+/* 一个函数最多声明的令牌个数 */
+#define XF_INIT_RESOURCE_LIST_MAX   8
+
+/* 名字长度用 uint8_t 保存 */
+#if (XF_INIT_RESOURCE_NAME_SIZE < 2) || (XF_INIT_RESOURCE_NAME_SIZE > UINT8_MAX + 1)
+#error "XF_INIT_RESOURCE_NAME_SIZE must be in [2, 256]"
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct _xf_init_resource_t {
+    char name[XF_INIT_RESOURCE_NAME_SIZE];  /*!< 令牌名的副本 */
+    uint8_t name_len;
+    uint16_t capacity;
+    uint16_t in_use;
+} xf_init_resource_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static xf_init_resource_t *xf_init_resource_get(const char *name, size_t len, bool create);
+static size_t xf_init_resource_parse(const char *list, xf_init_resource_t **pp_res);
+static const char *xf_init_resource_trim(const char *name, size_t *p_len);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_resource_t s_res[XF_INIT_RESOURCE_MAX];
+static size_t s_res_count = 0;
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_init_resource_set_capacity(const char *name, uint16_t capacity)
+{
+    xf_init_resource_t *p_res;
+    size_t len;
+
+    if ((NULL == name) || (capacity == 0)) {
+        return XF_ERR_INVALID_ARG;
+    }
+    len = strlen(name);
+    name = xf_init_resource_trim(name, &len);
+    if ((len == 0) || (len >= XF_INIT_RESOURCE_NAME_SIZE) || (memchr(name, ',', len) != NULL)) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    /* 调度在持有调度锁时读取令牌表 */
+    xf_init_dispatch_lock();
+    p_res = xf_init_resource_get(name, len, true);
+    if (NULL != p_res) {
+        p_res->capacity = capacity;
+    }
+    xf_init_dispatch_unlock();
+
+    return (NULL != p_res) ? XF_OK : XF_ERR_NO_MEM;
+}
+
+uint16_t xf_init_resource_capacity(const char *name)
+{
+    xf_init_resource_t *p_res;
+    uint16_t capacity = XF_INIT_RESOURCE_DEFAULT_CAPACITY;
+    size_t len;
+
+    if (NULL == name) {
+        return capacity;
+    }
+    len = strlen(name);
+    name = xf_init_resource_trim(name, &len);
+
+    xf_init_dispatch_lock();
+    p_res = xf_init_resource_get(name, len, false);
+    if (NULL != p_res) {
+        capacity = p_res->capacity;
+    }
+    xf_init_dispatch_unlock();
+
+    return capacity;
+}
+
+bool xf_init_resource_try_acquire(const char *list)
+{
+    xf_init_resource_t *res[XF_INIT_RESOURCE_LIST_MAX];
+    size_t count = xf_init_resource_parse(list, res);
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (res[i]->in_use >= res[i]->capacity) {
+            return false;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        res[i]->in_use++;
+    }
+    return true;
+}
+
+void xf_init_resource_release(const char *list)
+{
+    xf_init_resource_t *res[XF_INIT_RESOURCE_LIST_MAX];
+    size_t count = xf_init_resource_parse(list, res);
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (res[i]->in_use > 0) {
+            res[i]->in_use--;
+        }
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static xf_init_resource_t *xf_init_resource_get(const char *name, size_t len, bool create)
+{
+    xf_init_resource_t *p_res;
+    size_t i;
+
+    for (i = 0; i < s_res_count; i++) {
+        p_res = &s_res[i];
+        if ((p_res->name_len == len) && (memcmp(p_res->name, name, len) == 0)) {
+            return p_res;
+        }
+    }
+    if (!create || (s_res_count == XF_INIT_RESOURCE_MAX)) {
+        return NULL;
+    }
+    p_res = &s_res[s_res_count++];
+    *p_res = (xf_init_resource_t) {
+        .name_len   = (uint8_t)len,
+        .capacity   = XF_INIT_RESOURCE_DEFAULT_CAPACITY,
+    };
+    memcpy(p_res->name, name, len);
+    return p_res;
+}
+
+/*
+ * 把逗号分隔的列表解析为令牌, 名字两端的空白被忽略, 第一次出现的令牌以默认容量创建.
+ * 重复的名字只计一次, 否则容量为 1 的令牌永远无法同时获取两次.
+ * 令牌表已满或名字过长时该令牌不受限制 (只告警), 不能因为配置问题让初始化卡死.
+ */
+static size_t xf_init_resource_parse(const char *list, xf_init_resource_t **pp_res)
+{
+    size_t count = 0;
+    const char *p = list;
+
+    while ((NULL != p) && (*p != '\0') && (count < XF_INIT_RESOURCE_LIST_MAX)) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        const char *name = xf_init_resource_trim(p, &len);
+        xf_init_resource_t *p_res = NULL;
+        size_t i;
+
+        if (len >= XF_INIT_RESOURCE_NAME_SIZE) {
+            XF_LOGW(TAG, "resource name too long, '%.*s' is not limited.", (int)len, name);
+        } else if (len > 0) {
+            p_res = xf_init_resource_get(name, len, true);
+            if (NULL == p_res) {
+                XF_LOGW(TAG, "too many resources, '%.*s' is not limited.", (int)len, name);
+            }
+        }
+        for (i = 0; (NULL != p_res) && (i < count); i++) {
+            if (pp_res[i] == p_res) {
+                p_res = NULL;
+            }
+        }
+        if (NULL != p_res) {
+            pp_res[count++] = p_res;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return count;
+}
+
+/* 去掉名字两端的空格与制表符, 如 "i2c0, fw" 中的 " fw" */
+static const char *xf_init_resource_trim(const char *name, size_t *p_len)
+{
+    size_t len = *p_len;
+
+    while ((len > 0) && ((*name == ' ') || (*name == '\t'))) {
+        name++;
+        len--;
+    }
+    while ((len > 0) && ((name[len - 1] == ' ') || (name[len - 1] == '\t'))) {
+        len--;
+    }
+    *p_len = len;
+    return name;
+}
+
+#endif /* XF_INIT_ENABLE_RESOURCE */
@@ -0,0 +1,102 @@
+/**
+ * @file xf_init_resource.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 并发初始化时限制共享资源（总线、固件加载器、磁盘等）并发数的资源令牌。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_RESOURCE_H__
+#define __XF_INIT_RESOURCE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_RESOURCE || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_resource resource
+ * @brief 同一等级内的函数并发执行时 (`XF_INIT_ENABLE_PARALLEL_INIT` / `XF_INIT_ENABLE_PARALLEL_RESUME`),
+ * 共享同一物理资源的函数会相互争用. 用 `XF_INIT_EXPORT_RESOURCE` 导出时声明所需的资源令牌,
+ * 调度时只挑选所需令牌都有空余的函数执行, 冲突的函数自动错开, 不冲突的函数照常并发.
+ * 需要开启 `XF_INIT_ENABLE_RESOURCE`.
+ *
+ * - 令牌按名字区分, 一个函数可以用逗号分隔声明多个, 如 "i2c0,fw" 或 "i2c0, fw" (名字两端的空白被忽略);
+ * - 名字被复制保存, 长度不超过 `XF_INIT_RESOURCE_NAME_SIZE` - 1, 更长的名字不受限制 (只告警);
+ * - 每个令牌的容量默认为 `XF_INIT_RESOURCE_DEFAULT_CAPACITY` (1 即互斥),
+ *   可在 xf_init 之前用 @ref xf_init_resource_set_capacity 修改 (如磁盘允许 4 个并发);
+ * - 顺序执行时令牌没有作用, 也没有开销.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 设置资源令牌的容量, 即同时持有该令牌的函数个数上限.
+ *
+ * 可以随时调用; 正在执行的函数不受影响, 之后的调度按新容量进行.
+ *
+ * @param name 令牌名, 会被复制, 两端的空白被忽略.
+ * @param capacity 容量, 至少为 1.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_ARG        参数错误 (名字为空、含逗号或过长)
+ *      - XF_ERR_NO_MEM             令牌个数超过 `XF_INIT_RESOURCE_MAX`
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_resource_set_capacity(const char *name, uint16_t capacity);
+
+/**
+ * @brief 获取资源令牌的容量.
+ *
+ * @param name 令牌名.
+ * @return uint16_t 容量, 未设置过的令牌为 `XF_INIT_RESOURCE_DEFAULT_CAPACITY`.
+ */
+uint16_t xf_init_resource_capacity(const char *name);
+
+/**
+ * @brief （内部函数）尝试获取列表中的所有令牌, 要么全部获取, 要么一个也不获取.
+ *
+ * 只由并发调度在持有调度锁时调用, 本身不加锁.
+ *
+ * @param list 逗号分隔的令牌名.
+ * @return bool 是否已获取.
+ */
+bool xf_init_resource_try_acquire(const char *list);
+
+/**
+ * @brief （内部函数）释放 @ref xf_init_resource_try_acquire 获取的令牌. 同样需持有调度锁.
+ *
+ * @param list 逗号分隔的令牌名.
+ */
+void xf_init_resource_release(const char *list);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_resource
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_RESOURCE */
+
+#endif /* __XF_INIT_RESOURCE_H__ */
@@ -0,0 +1,363 @@
+/**
+ * @file xf_init_retry.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 失败的初始化函数按退避策略异步重试。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_retry.h"
+
+#if XF_INIT_ENABLE_RETRY
+
+#include <string.h>
+
+#if XF_INIT_RETRY_USE_THREAD
+#   include <pthread.h>
+#   include <time.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "retry"
+
+#define XF_INIT_RETRY_NEVER     UINT64_MAX
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static xf_init_retry_entry_t *xf_init_retry_next(uint64_t *p_wait_us);
+static void xf_init_retry_update(xf_init_retry_entry_t *p_entry, int result);
+static bool xf_init_retry_blocking(uint8_t level);
+static void xf_init_retry_execute(xf_init_retry_entry_t *p_entry);
+
+#if XF_INIT_RETRY_USE_THREAD
+static void xf_init_retry_start(void);
+static void xf_init_retry_wait_step(uint64_t max_wait_us);
+static void *xf_init_retry_worker(void *arg);
+static int xf_init_retry_timedwait(pthread_cond_t *p_cond, uint64_t wait_us);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_retry_entry_t *s_head = NULL;
+static size_t s_pending = 0;
+
+#if XF_INIT_RETRY_USE_THREAD
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond_work = PTHREAD_COND_INITIALIZER;       /*!< 有新的重试 */
+static pthread_cond_t s_cond_settled = PTHREAD_COND_INITIALIZER;    /*!< 有重试结束 */
+static bool s_started = false;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+#if XF_INIT_RETRY_USE_THREAD
+#   define xf_init_retry_lock()     pthread_mutex_lock(&s_lock)
+#   define xf_init_retry_unlock()   pthread_mutex_unlock(&s_lock)
+#else
+#   define xf_init_retry_lock()
+#   define xf_init_retry_unlock()
+#endif
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_init_retry_run(xf_init_retry_entry_t *p_entry)
+{
+    int result = p_entry->func();
+
+    xf_init_retry_lock();
+    if (p_entry->attempts == 0) {
+        p_entry->p_next = s_head;
+        s_head = p_entry;
+    }
+    xf_init_retry_update(p_entry, result);
+    if (p_entry->state == XF_INIT_RETRY_STATE_PENDING) {
+#if XF_INIT_RETRY_USE_THREAD
+        xf_init_retry_start();
+        pthread_cond_signal(&s_cond_work);
+#endif
+    }
+    xf_init_retry_unlock();
+
+    return result;
+}
+
+xf_err_t xf_init_retry_status(const char *func_name, xf_init_retry_status_t *p_status)
+{
+    xf_init_retry_entry_t *p_entry;
+    xf_err_t err = XF_ERR_NOT_FOUND;
+
+    if ((NULL == func_name) || (NULL == p_status)) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    xf_init_retry_lock();
+    for (p_entry = s_head; p_entry; p_entry = p_entry->p_next) {
+        if (strcmp(p_entry->func_name, func_name) == 0) {
+            p_status->state     = (xf_init_retry_state_t)p_entry->state;
+            p_status->attempts  = p_entry->attempts;
+            p_status->result    = p_entry->result;
+            err = XF_OK;
+            break;
+        }
+    }
+    xf_init_retry_unlock();
+
+    return err;
+}
+
+size_t xf_init_retry_pending(void)
+{
+    size_t pending;
+    xf_init_retry_lock();
+    pending = s_pending;
+    xf_init_retry_unlock();
+    return pending;
+}
+
+xf_err_t xf_init_retry_wait(uint32_t timeout_ms)
+{
+    uint64_t deadline_us = (timeout_ms == 0) ? XF_INIT_RETRY_NEVER
+                           : xf_init_dispatch_time_us() + (uint64_t)timeout_ms * 1000u;
+    xf_err_t err = XF_OK;
+
+    xf_init_retry_lock();
+    while (s_pending > 0) {
+        uint64_t now_us = xf_init_dispatch_time_us();
+        if (now_us >= deadline_us) {
+            err = XF_ERR_TIMEOUT;
+            break;
+        }
+#if XF_INIT_RETRY_USE_THREAD
+        xf_init_retry_wait_step((deadline_us == XF_INIT_RETRY_NEVER) ? XF_INIT_RETRY_NEVER : deadline_us - now_us);
+#else
+        xf_init_retry_poll();
+#endif
+    }
+    xf_init_retry_unlock();
+
+    return err;
+}
+
+uint32_t xf_init_retry_poll(void)
+{
+    xf_init_retry_entry_t *p_entry;
+    uint64_t wait_us = XF_INIT_RETRY_NEVER;
+
+    xf_init_retry_lock();
+    while ((p_entry = xf_init_retry_next(&wait_us)) != NULL) {
+        xf_init_retry_execute(p_entry);
+    }
+    xf_init_retry_unlock();
+
+    return (wait_us == XF_INIT_RETRY_NEVER) ? UINT32_MAX : (uint32_t)((wait_us + 999u) / 1000u);
+}
+
+void xf_init_retry_barrier(uint8_t level)
+{
+    xf_init_retry_lock();
+    while (xf_init_retry_blocking(level)) {
+#if XF_INIT_RETRY_USE_THREAD
+        xf_init_retry_wait_step(XF_INIT_RETRY_NEVER);
+#else
+        xf_init_retry_poll();
+#endif
+    }
+    xf_init_retry_unlock();
+}
+
+void xf_init_retry_atfork_child(void)
+{
+#if XF_INIT_RETRY_USE_THREAD
+    xf_init_retry_entry_t *p_entry;
+
+    /* 重试线程不会出现在子进程中, 正在执行的重试视为未执行, 由新线程重新执行 */
+    s_lock = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    s_cond_work = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    s_cond_settled = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    s_started = false;
+    for (p_entry = s_head; p_entry; p_entry = p_entry->p_next) {
+        p_entry->running = false;
+    }
+    if (s_pending > 0) {
+        xf_init_retry_start();
+    }
+#endif
+}
+
+/* ==================== [Static Functions] ================================== */
+
+/* 返回已到期的重试; 没有时 *p_wait_us 为距最近一次重试的时间 */
+static xf_init_retry_entry_t *xf_init_retry_next(uint64_t *p_wait_us)
+{
+    xf_init_retry_entry_t *p_entry;
+    uint64_t now_us = xf_init_dispatch_time_us();
+
+    *p_wait_us = XF_INIT_RETRY_NEVER;
+    for (p_entry = s_head; p_entry; p_entry = p_entry->p_next) {
+        if ((p_entry->state != XF_INIT_RETRY_STATE_PENDING) || p_entry->running) {
+            continue;
+        }
+        if (p_entry->due_us <= now_us) {
+            return p_entry;
+        }
+        if (p_entry->due_us - now_us < *p_wait_us) {
+            *p_wait_us = p_entry->due_us - now_us;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 记录一次执行的结果, 决定放弃还是安排下一次; 调用时已持有锁.
+ * 只有执行过且等待重试的才计入 s_pending; 已结束的条目被再次执行 (如重复调用 xf_init_levels) 时不能减.
+ */
+static void xf_init_retry_update(xf_init_retry_entry_t *p_entry, int result)
+{
+    bool was_pending = (p_entry->state == XF_INIT_RETRY_STATE_PENDING) && (p_entry->attempts > 0);
+
+    p_entry->attempts++;
+    p_entry->result = result;
+    p_entry->running = false;
+
+    if ((result != 0) && (p_entry->attempts < p_entry->max_attempts)) {
+        uint32_t shift = (p_entry->attempts - 1u < 31u) ? (p_entry->attempts - 1u) : 31u;
+        uint64_t delay_ms = (uint64_t)p_entry->backoff_ms << shift;
+        if (delay_ms > XF_INIT_RETRY_MAX_BACKOFF_MS) {
+            delay_ms = XF_INIT_RETRY_MAX_BACKOFF_MS;
+        }
+        p_entry->state = XF_INIT_RETRY_STATE_PENDING;
+        if (!was_pending) {
+            s_pending++;
+        }
+        p_entry->due_us = xf_init_dispatch_time_us() + delay_ms * 1000u;
+        XF_LOGW(TAG, "%s failed [ret: %d], retry %u/%u in %u ms.", p_entry->func_name, result,
+                (unsigned)p_entry->attempts + 1u, (unsigned)p_entry->max_attempts, (unsigned)delay_ms);
+        return;
+    }
+
+    p_entry->state = (result == 0) ? XF_INIT_RETRY_STATE_DONE : XF_INIT_RETRY_STATE_FAILED;
+    if (result != 0) {
+        XF_LOGE(TAG, "%s failed after %u attempts [ret: %d].", p_entry->func_name,
+                (unsigned)p_entry->attempts, result);
+    }
+    if (was_pending) {
+        s_pending--;
+    }
+}
+
+static bool xf_init_retry_blocking(uint8_t level)
+{
+    xf_init_retry_entry_t *p_entry;
+    for (p_entry = s_head; p_entry; p_entry = p_entry->p_next) {
+        if ((p_entry->flags & XF_INIT_RETRY_WAIT)
+                && (p_entry->level_num <= level)
+                && (p_entry->state == XF_INIT_RETRY_STATE_PENDING)
+                && (p_entry->attempts > 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 调用时已持有锁, 执行期间释放 */
+static void xf_init_retry_execute(xf_init_retry_entry_t *p_entry)
+{
+    int result;
+
+    p_entry->running = true;
+    xf_init_retry_unlock();
+    result = xf_init_dispatch_call(XF_INIT_STAGE_INIT, p_entry->level_num, p_entry->func, p_entry->func_name);
+    xf_init_retry_lock();
+    xf_init_retry_update(p_entry, result);
+#if XF_INIT_RETRY_USE_THREAD
+    /* 每次重试结束都通知, 仍需重试时自己执行重试的等待者 (见 xf_init_retry_wait_step) 也要重新计算等待时间 */
+    pthread_cond_broadcast(&s_cond_settled);
+#endif
+}
+
+#if XF_INIT_RETRY_USE_THREAD
+
+/* 第一次需要重试时创建, 之后常驻 */
+static void xf_init_retry_start(void)
+{
+    pthread_t thread;
+    if (s_started) {
+        return;
+    }
+    if (pthread_create(&thread, NULL, xf_init_retry_worker, NULL) != 0) {
+        XF_LOGE(TAG, "failed to start retry thread, retries run in xf_init_retry_poll() and waiters.");
+        return;
+    }
+    pthread_detach(thread);
+    s_started = true;
+}
+
+/*
+ * 等待重试状态变化, 最多 max_wait_us; 调用时已持有锁.
+ * 重试线程创建失败时没有人会执行重试, 由等待者自己执行到期的重试, 否则启动会一直卡在这里.
+ */
+static void xf_init_retry_wait_step(uint64_t max_wait_us)
+{
+    xf_init_retry_entry_t *p_entry;
+    uint64_t wait_us = XF_INIT_RETRY_NEVER;
+
+    if (!s_started) {
+        p_entry = xf_init_retry_next(&wait_us);
+        if (p_entry) {
+            xf_init_retry_execute(p_entry);
+            return;
+        }
+    }
+    if (max_wait_us < wait_us) {
+        wait_us = max_wait_us;
+    }
+    if (wait_us == XF_INIT_RETRY_NEVER) {
+        pthread_cond_wait(&s_cond_settled, &s_lock);
+    } else {
+        xf_init_retry_timedwait(&s_cond_settled, wait_us);
+    }
+}
+
+static void *xf_init_retry_worker(void *arg)
+{
+    xf_init_retry_entry_t *p_entry;
+    uint64_t wait_us;
+
+    UNUSED(arg);
+    xf_init_retry_lock();
+    for (;;) {
+        p_entry = xf_init_retry_next(&wait_us);
+        if (p_entry) {
+            xf_init_retry_execute(p_entry);
+        } else if (wait_us == XF_INIT_RETRY_NEVER) {
+            pthread_cond_wait(&s_cond_work, &s_lock);
+        } else {
+            xf_init_retry_timedwait(&s_cond_work, wait_us);
+        }
+    }
+    xf_init_retry_unlock();
+    return NULL;
+}
+
+/* 条件变量默认使用 CLOCK_REALTIME, 只用于计算相对的等待时间 */
+static int xf_init_retry_timedwait(pthread_cond_t *p_cond, uint64_t wait_us)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    wait_us += (uint64_t)ts.tv_nsec / 1000u;
+    ts.tv_sec += (time_t)(wait_us / 1000000u);
+    ts.tv_nsec = (long)(wait_us % 1000000u) * 1000L;
+    return pthread_cond_timedwait(p_cond, &s_lock, &ts);
+}
+
+#endif /* XF_INIT_RETRY_USE_THREAD */
+
+#endif /* XF_INIT_ENABLE_RETRY */
@@ -0,0 +1,190 @@
+/**
+ * @file xf_init_retry.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 失败的初始化函数按退避策略异步重试。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_RETRY_H__
+#define __XF_INIT_RETRY_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_RETRY || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_retry retry
+ * @brief 依赖尚未就绪而失败的初始化函数, 不在函数内部循环等待, 而是交给后台按指数退避重试,
+ * 启动流程继续执行其他函数. 需要开启 `XF_INIT_ENABLE_RETRY`.
+ *
+ * - 第一次在所属等级内按原顺序执行, 失败后按 `backoff`, `2 * backoff`, ... 毫秒
+ *   (不超过 `XF_INIT_RETRY_MAX_BACKOFF_MS`) 重试, 总共最多执行 attempts 次;
+ * - `XF_INIT_RETRY_WAIT`: 更高等级的函数 (依赖方) 开始前等待它成功或放弃重试;
+ *   `XF_INIT_RETRY_ASYNC`: 启动流程不等待;
+ * - POSIX 上由一个后台线程重试 (线程创建失败时由等待重试的调用者自己执行);
+ *   其他平台需要在主循环中调用 @ref xf_init_retry_poll.
+ *
+ * 最终结果通过 @ref xf_init_retry_status 查询.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define XF_INIT_RETRY_ASYNC         0x00    /*!< 依赖方不等待 */
+#define XF_INIT_RETRY_WAIT          0x01    /*!< 更高等级开始前等待重试结束 */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 重试状态.
+ */
+typedef enum _xf_init_retry_state_t {
+    XF_INIT_RETRY_STATE_PENDING = 0x00,     /*!< 尚未执行或等待重试 */
+    XF_INIT_RETRY_STATE_DONE,               /*!< 成功 */
+    XF_INIT_RETRY_STATE_FAILED,             /*!< 达到最大次数仍失败 */
+} xf_init_retry_state_t;
+
+/**
+ * @brief 查询结果.
+ */
+typedef struct _xf_init_retry_status_t {
+    xf_init_retry_state_t state;            /*!< 状态 */
+    uint16_t attempts;                      /*!< 已执行的次数 */
+    int result;                             /*!< 最后一次执行的返回值 */
+} xf_init_retry_status_t;
+
+/**
+ * @brief （内部使用）一个可重试的初始化函数, 由 @ref XF_INIT_EXPORT_RETRY 静态定义.
+ */
+typedef struct _xf_init_retry_entry_t {
+    int (*func)(void);                      /*!< 初始化函数 */
+    const char *func_name;                  /*!< 函数名 */
+    uint8_t level_num;                      /*!< 等级, 见 XF_INIT_LEVEL_* */
+    uint8_t flags;                          /*!< XF_INIT_RETRY_WAIT / XF_INIT_RETRY_ASYNC */
+    uint16_t max_attempts;                  /*!< 最多执行次数 (含第一次) */
+    uint32_t backoff_ms;                    /*!< 第一次重试前的间隔 */
+
+    /* 以下由 retry 模块维护 */
+    uint8_t state;                          /*!< 见 @ref xf_init_retry_state_t */
+    bool running;                           /*!< 正在执行 */
+    uint16_t attempts;                      /*!< 已执行的次数 */
+    int result;                             /*!< 最后一次的返回值 */
+    uint64_t due_us;                        /*!< 下一次重试的时间 */
+    struct _xf_init_retry_entry_t *p_next;
+} xf_init_retry_entry_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 查询可重试的初始化函数的状态.
+ *
+ * @param func_name 函数名 (@ref XF_INIT_EXPORT_RETRY 的 function).
+ * @param[out] p_status 状态.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_ARG        参数无效
+ *      - XF_ERR_NOT_FOUND          尚未执行过或不存在
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_retry_status(const char *func_name, xf_init_retry_status_t *p_status);
+
+/**
+ * @brief 获取等待重试的函数个数.
+ *
+ * @return size_t 个数.
+ */
+size_t xf_init_retry_pending(void);
+
+/**
+ * @brief 等待所有重试结束 (成功或放弃).
+ *
+ * @param timeout_ms 超时时间, 0 表示一直等待.
+ * @return xf_err_t
+ *      - XF_ERR_TIMEOUT            超时
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_retry_wait(uint32_t timeout_ms);
+
+/**
+ * @brief 执行已到期的重试. 没有后台线程 (`XF_INIT_RETRY_USE_THREAD` 为 0) 时需要周期调用.
+ *
+ * @return uint32_t 距下一次重试的毫秒数, 没有等待重试的函数时为 UINT32_MAX.
+ */
+uint32_t xf_init_retry_poll(void);
+
+/**
+ * @brief （内部函数）执行第一次, 失败时安排重试. 由 @ref XF_INIT_EXPORT_RETRY 生成的函数调用.
+ *
+ * @param p_entry 可重试的初始化函数.
+ * @return int 第一次执行的返回值.
+ */
+int xf_init_retry_run(xf_init_retry_entry_t *p_entry);
+
+/**
+ * @brief （内部函数）即将执行 level 之后的等级, 等待 level 及以下带有 `XF_INIT_RETRY_WAIT` 的重试结束.
+ *
+ * @param level 已执行完的等级.
+ */
+void xf_init_retry_barrier(uint8_t level);
+
+/**
+ * @brief （内部函数）fork 之后在子进程中调用, 重建后台线程.
+ */
+void xf_init_retry_atfork_child(void);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * @brief 导出可重试的初始化函数.
+ *
+ * 实际注册的函数名为 `function_retry`, 注册表模式下在注册表中填写
+ * `XF_INIT_REGISTER_<LEVEL>(function_retry)`. 函数在重试时由后台线程调用,
+ * 不要使用 `__xf_init` 标记.
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 DEVICE.
+ * @param attempts 最多执行次数 (含第一次).
+ * @param backoff 第一次重试前的间隔 (ms), 之后每次加倍.
+ * @param policy XF_INIT_RETRY_WAIT 或 XF_INIT_RETRY_ASYNC.
+ */
+#define XF_INIT_EXPORT_RETRY(function, level, attempts, backoff, policy) \
+    static int function##_retry(void) \
+    { \
+        static xf_init_retry_entry_t s_entry = { \
+            .func           = (function), \
+            .func_name      = #function, \
+            .level_num      = XF_INIT_LEVEL_##level, \
+            .flags          = (policy), \
+            .max_attempts   = (attempts), \
+            .backoff_ms     = (backoff), \
+        }; \
+        return xf_init_retry_run(&s_entry); \
+    } \
+    XF_INIT_EXPORT_##level(function##_retry)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_retry
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_RETRY */
+
+#endif /* __XF_INIT_RETRY_H__ */
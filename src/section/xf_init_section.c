@@ -12,6 +12,9 @@
 /* ==================== [Includes] ========================================== */
 
 #include "xf_init_section.h"
+#include "../profile/xf_init_profile.h"
+#include "../release/xf_init_release.h"
+#include "../warmup/xf_init_warmup.h"
 #include "xf_utils.h"
 
 #if XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION
@@ -25,32 +28,233 @@
 /* ==================== [Static Prototypes] ================================= */
 
 static int start(void);
-XF_INIT_EXPORT_SECTION(start, "0");
+XF_INIT_EXPORT_SECTION(start, 0);
+XF_INIT_EXPORT_SECTION_STAGE(start, suspend, 0);
+XF_INIT_EXPORT_SECTION_STAGE(start, resume, 0);
+XF_INIT_EXPORT_SECTION_STAGE(start, postfork, 0);
+XF_INIT_EXPORT_SECTION_STAGE(start, warmup, 0);
 static int end(void);
-XF_INIT_EXPORT_SECTION(end, "9");
+XF_INIT_EXPORT_SECTION(end, 9);
+XF_INIT_EXPORT_SECTION_STAGE(end, suspend, 9);
+XF_INIT_EXPORT_SECTION_STAGE(end, resume, 9);
+XF_INIT_EXPORT_SECTION_STAGE(end, postfork, 9);
+XF_INIT_EXPORT_SECTION_STAGE(end, warmup, 9);
+
+static int xf_init_section_run_stage(const xf_init_section_desc_t *start_desc,
+                                     const xf_init_section_desc_t *end_desc,
+                                     xf_init_stage_t stage, bool parallel);
+static xf_init_dispatch_job_t xf_init_section_job(const xf_init_section_desc_t *desc, xf_init_stage_t stage);
+static inline const xf_init_section_desc_t *xf_init_section_bound(const xf_init_section_desc_t *desc);
 
 /* ==================== [Static Variables] ================================== */
 
+#if XF_INIT_ENABLE_RELEASE
+static bool s_released = false;
+#endif
+
 /* ==================== [Macros] ============================================ */
 
 /* ==================== [Global Functions] ================================== */
 
 void xf_init_from_section(void)
 {
-    int result = 0;
-    UNUSED(result);
-    const xf_init_section_desc_t *desc = &__xf_init_start;
-    for (desc++; desc < &__xf_init_end; desc++) {
+    xf_init_levels_from_section(XF_INIT_LEVEL_SETUP, XF_INIT_LEVEL_APP);
+}
+
+void xf_init_levels_from_section(uint8_t first, uint8_t last)
+{
+    const xf_init_section_desc_t *begin = xf_init_section_bound(&__xf_init_start);
+    const xf_init_section_desc_t *end = xf_init_section_bound(&__xf_init_end);
+    const xf_init_section_desc_t *desc = begin;
+    uint8_t level = 0;
+#if XF_INIT_ENABLE_PARALLEL_INIT
+    /* 同一等级 (段内连续) 攒成一批并发执行, 等级切换前执行完 */
+    xf_init_dispatch_job_t jobs[XF_INIT_PARALLEL_BATCH];
+    size_t count = 0;
+#endif
+#if XF_INIT_ENABLE_RELEASE
+    if (s_released) {
+        return;
+    }
+#endif
+#if XF_INIT_ENABLE_PROFILE
+    xf_init_profile_prepare(xf_init_section_for_each);
+#endif
+    for (desc++; desc < end; desc++) {
+        if (desc->level > last) {
+            break;
+        }
+        if ((NULL == desc->func) || (desc->level < first)) {
+            continue;
+        }
+#if XF_INIT_ENABLE_PROFILE
+        if (xf_init_profile_skipped((size_t)(desc - begin - 1))) {
+            continue;
+        }
+#endif
+#if XF_INIT_ENABLE_PARALLEL_INIT
+        if ((count > 0) && ((desc->level != level) || (count == XF_INIT_PARALLEL_BATCH))) {
+            xf_init_dispatch_parallel(jobs, count);
+            count = 0;
+        }
+#endif
+        if (desc->level != level) {
+            xf_init_dispatch_level_done(desc->level - 1);
+            level = desc->level;
+        }
+#if XF_INIT_ENABLE_PARALLEL_INIT
+        jobs[count++] = xf_init_section_job(desc, XF_INIT_STAGE_INIT);
+#else
+        xf_init_dispatch_call(XF_INIT_STAGE_INIT, desc->level, desc->func, desc->func_name);
+#endif
+    }
+#if XF_INIT_ENABLE_PARALLEL_INIT
+    xf_init_dispatch_parallel(jobs, count);
+#endif
+    xf_init_dispatch_level_done(last);
+}
+
+void xf_init_section_for_each(xf_init_dispatch_entry_cb_t cb, void *user_data)
+{
+    const xf_init_section_desc_t *begin = xf_init_section_bound(&__xf_init_start);
+    const xf_init_section_desc_t *end = xf_init_section_bound(&__xf_init_end);
+    const xf_init_section_desc_t *desc = begin;
+#if XF_INIT_ENABLE_RELEASE
+    /* 描述符已回收, 与 registry 模式一致, 视为没有初始化函数 */
+    if (s_released) {
+        return;
+    }
+#endif
+    for (desc++; desc < end; desc++) {
+        if (NULL == desc->func) {
+            continue;
+        }
+        if (!cb((size_t)(desc - begin - 1), desc->func_name, desc->level, user_data)) {
+            break;
+        }
+    }
+}
+
+xf_err_t xf_init_suspend_from_section(void)
+{
+    const xf_init_section_desc_t *begin = xf_init_section_bound(&__xf_init_suspend_start);
+    const xf_init_section_desc_t *desc = xf_init_section_bound(&__xf_init_suspend_end);
+    for (desc--; desc > begin; desc--) {
+        if (NULL == desc->func) {
+            continue;
+        }
+        if (xf_init_dispatch_call(XF_INIT_STAGE_SUSPEND, desc->level, desc->func, desc->func_name) != 0) {
+            XF_LOGE(TAG, "suspend %s failed, abort.", desc->func_name);
+            return XF_FAIL;
+        }
+    }
+    return XF_OK;
+}
+
+xf_err_t xf_init_resume_from_section(void)
+{
+    int result = xf_init_section_run_stage(xf_init_section_bound(&__xf_init_resume_start),
+                                           xf_init_section_bound(&__xf_init_resume_end),
+                                           XF_INIT_STAGE_RESUME, XF_INIT_ENABLE_PARALLEL_RESUME);
+    return (result == 0) ? XF_OK : XF_FAIL;
+}
+
+xf_err_t xf_init_postfork_from_section(void)
+{
+    int result = xf_init_section_run_stage(xf_init_section_bound(&__xf_init_postfork_start),
+                                           xf_init_section_bound(&__xf_init_postfork_end),
+                                           XF_INIT_STAGE_POSTFORK, false);
+    return (result == 0) ? XF_OK : XF_FAIL;
+}
+
+#if XF_INIT_ENABLE_RELEASE
+size_t xf_init_section_release(void)
+{
+    /* 初始化描述符之后到第一个阶段 (postfork) 首描述符之前是函数名, 尾描述符在 profile 等遍历中不再使用 */
+    const xf_init_section_desc_t *begin = xf_init_section_bound(&__xf_init_start);
+    const xf_init_section_desc_t *end = xf_init_section_bound(&__xf_init_postfork_start);
+
+    s_released = true;
+    return xf_init_release_rodata(begin + 1, end);
+}
+#endif
+
+#if XF_INIT_ENABLE_WARMUP
+void xf_init_warmup_from_section(void)
+{
+    const xf_init_section_desc_t *desc = xf_init_section_bound(&__xf_init_warmup_start);
+    const xf_init_section_desc_t *end = xf_init_section_bound(&__xf_init_warmup_end);
+    for (desc++; desc < end; desc++) {
         if (NULL == desc->func) {
             continue;
         }
-        result = desc->func();
-        XF_LOGD(TAG, "initialize [ret: %d] %s done.", result, desc->func_name);
+        if (!xf_init_warmup_call(desc->level, desc->func, desc->func_name)) {
+            break;
+        }
     }
 }
+#endif
 
 /* ==================== [Static Functions] ================================== */
 
+/* 按等级从低到高执行, 失败不中断; parallel 时同一等级 (段内连续) 攒成一批并发执行 */
+static int xf_init_section_run_stage(const xf_init_section_desc_t *start_desc,
+                                     const xf_init_section_desc_t *end_desc,
+                                     xf_init_stage_t stage, bool parallel)
+{
+    xf_init_dispatch_job_t jobs[XF_INIT_PARALLEL_BATCH];
+    size_t count = 0;
+    int result = 0;
+    const xf_init_section_desc_t *desc = start_desc;
+
+    for (desc++; desc <= end_desc; desc++) {
+        if ((count > 0)
+                && ((desc == end_desc)
+                    || (desc->level != jobs[0].level)
+                    || (count == XF_INIT_PARALLEL_BATCH))) {
+            if (xf_init_dispatch_parallel(jobs, count) != 0) {
+                result = -1;
+            }
+            count = 0;
+        }
+        if ((desc == end_desc) || (NULL == desc->func)) {
+            continue;
+        }
+        if (!parallel) {
+            if (xf_init_dispatch_call(stage, desc->level, desc->func, desc->func_name) != 0) {
+                result = -1;
+            }
+            continue;
+        }
+        jobs[count++] = xf_init_section_job(desc, stage);
+    }
+    return result;
+}
+
+static xf_init_dispatch_job_t xf_init_section_job(const xf_init_section_desc_t *desc, xf_init_stage_t stage)
+{
+    return (xf_init_dispatch_job_t) {
+        .func       = desc->func,
+        .func_name  = desc->func_name,
+        .stage      = (uint8_t)stage,
+        .level      = desc->level,
+#if XF_INIT_ENABLE_RESOURCE
+        .resource   = desc->resource,
+#endif
+    };
+}
+
+/*
+ * 首尾描述符定义在本文件中, 编译器知道它们各自只是一个对象, 从其地址越界遍历整个段是未定义行为,
+ * GCC -O2 会按首描述符的初始值折叠 (如把 level 当作 0). 遍历段的边界一律经过一条空汇编,
+ * 编译器不再知道指针来自哪个对象, 只能按普通内存读取.
+ */
+static inline const xf_init_section_desc_t *xf_init_section_bound(const xf_init_section_desc_t *desc)
+{
+    __asm__("" : "+r"(desc));
+    return desc;
+}
+
 static int start(void)
 {
     return 0;
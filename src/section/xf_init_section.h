@@ -15,6 +15,7 @@
 /* ==================== [Includes] ========================================== */
 
 #include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
 
 #if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION) || defined(__DOXYGEN__)
 
@@ -58,6 +59,10 @@ typedef int (*xf_init_fn_t)(void);
 typedef struct _xf_init_section_desc_t {
     const xf_init_fn_t func;            /*!< 初始化函数 */
     const char *func_name;              /*!< 初始化函数的函数名 */
+    const uint8_t level;                /*!< 等级, 见 XF_INIT_LEVEL_* */
+#if XF_INIT_ENABLE_RESOURCE
+    const char *resource;               /*!< 所需的资源令牌, 逗号分隔, 可为 NULL */
+#endif
 } xf_init_section_desc_t;
 
 /* ==================== [Global Prototypes] ================================= */
@@ -67,22 +72,141 @@ typedef struct _xf_init_section_desc_t {
  */
 void xf_init_from_section(void);
 
+/**
+ * @brief 只调用 section 注册的指定等级范围内的初始化函数.
+ *
+ * @param first 起始等级 (含), 见 XF_INIT_LEVEL_*.
+ * @param last 结束等级 (含), 见 XF_INIT_LEVEL_*.
+ */
+void xf_init_levels_from_section(uint8_t first, uint8_t last);
+
+/**
+ * @brief 按执行顺序遍历 section 注册的初始化函数, 序号为描述符在段内的位置.
+ *
+ * @param cb 回调, 返回 false 时停止.
+ * @param user_data 用户数据.
+ */
+void xf_init_section_for_each(xf_init_dispatch_entry_cb_t cb, void *user_data);
+
+/**
+ * @brief 按等级从高到低调用 section 注册的挂起函数, 遇到失败时停止.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个挂起函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_suspend_from_section(void);
+
+/**
+ * @brief 按等级从低到高调用 section 注册的恢复函数.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个恢复函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_resume_from_section(void);
+
+/**
+ * @brief 按等级从低到高调用 section 注册的 fork 后重新初始化函数.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_postfork_from_section(void);
+
+/**
+ * @brief 按注册顺序调用 section 注册的预热函数, 由 warmup 模块决定是否继续.
+ */
+void xf_init_warmup_from_section(void);
+
+#if XF_INIT_ENABLE_RELEASE || defined(__DOXYGEN__)
+/**
+ * @brief 回收初始化函数的描述符与函数名, 由 xf_init_release 调用, 之后不再遍历初始化函数.
+ *
+ * 挂起 / 恢复 / fork 后重新初始化 / 预热的描述符排在其后, 不回收.
+ *
+ * @return size_t 回收的字节数, 只回收完整的页.
+ */
+size_t xf_init_section_release(void);
+#endif
+
 /* ==================== [Macros] ============================================ */
 
+/*
+ * 开启 XF_INIT_ENABLE_RELEASE 时, 初始化函数的函数名放在 ".xf_auto_init.9.name",
+ * 排序后位于尾描述符与第一个阶段描述符之间, 与描述符一起由 xf_init_section_release() 回收.
+ * 开启 XF_INIT_ENABLE_STATS 时统计记录会保存函数名指针, 函数名仍放在只读数据段.
+ */
+#if XF_INIT_ENABLE_RELEASE && !XF_INIT_ENABLE_STATS
+#   define XF_INIT_SECTION_NAME_DEFINE(function) \
+    static const char __xf_init_name_##function[] __section(".xf_auto_init.9.name") = XSTR(function);
+#   define XF_INIT_SECTION_NAME(function)           __xf_init_name_##function
+#else
+#   define XF_INIT_SECTION_NAME_DEFINE(function)
+#   define XF_INIT_SECTION_NAME(function)           XSTR(function)
+#endif
+
 /**
  * @brief 导出初始化函数到段.
  *
  * @attention 不要直接使用该宏, 也不要使用 `XF_INIT_EXPORT_SECTION_BOARD`,
  * 请用之后定义 `XF_INIT_*` 宏, 如 `XF_INIT_EXPORT_BOARD`.
  *
+ * 显式指定对齐, 避免编译器为较大的结构体提高对齐而在段内留下空隙.
+ *
  * @param function 初始化函数. 类型见 @ref xf_init_fn_t.
- * @param level 字符串等级. 范围: "1" ~ "8".
+ * @param level_num 数字等级. 范围: 1 ~ 8.
  */
-#define XF_INIT_EXPORT_SECTION(function, level) \
-    __used __section(".xf_auto_init." level)  \
+#define XF_INIT_EXPORT_SECTION(function, level_num) \
+    XF_INIT_SECTION_NAME_DEFINE(function) \
+    __used __section(".xf_auto_init." XSTR(level_num)) \
+    __attribute__((aligned(__alignof__(xf_init_section_desc_t)))) \
     const xf_init_section_desc_t __xf_init_##function = { \
+        .func       = (function), \
+        .func_name  = XF_INIT_SECTION_NAME(function), \
+        .level      = (level_num), \
+    }
+
+#if XF_INIT_ENABLE_RESOURCE
+/**
+ * @brief 导出声明了资源令牌的初始化函数到段.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_RESOURCE.
+ *
+ * @param function 初始化函数.
+ * @param level_name 等级, 如 DEVICE. (不能命名为 level, 会替换掉描述符的 .level)
+ * @param res 逗号分隔的资源令牌名, 如 "i2c0".
+ */
+#define XF_INIT_EXPORT_SECTION_RESOURCE(function, level_name, res) \
+    XF_INIT_SECTION_NAME_DEFINE(function) \
+    __used __section(".xf_auto_init." XSTR(XF_INIT_LEVEL_##level_name)) \
+    __attribute__((aligned(__alignof__(xf_init_section_desc_t)))) \
+    const xf_init_section_desc_t __xf_init_##function = { \
+        .func       = (function), \
+        .func_name  = XF_INIT_SECTION_NAME(function), \
+        .level      = XF_INIT_LEVEL_##level_name, \
+        .resource   = (res), \
+    }
+#endif
+
+/**
+ * @brief 导出挂起 / 恢复函数到段.
+ *
+ * 段名为 ".xf_auto_init_<stage>.<level>", 仍匹配链接脚本中的 `.xf_auto_init*`,
+ * 排序后位于初始化段之后, 各阶段由各自的首尾描述符界定.
+ *
+ * @param function 挂起 / 恢复函数. 类型见 @ref xf_init_fn_t.
+ * @param stage 阶段, suspend, resume, postfork 或 warmup.
+ * @param level_num 数字等级. 范围: 1 ~ 8.
+ */
+#define XF_INIT_EXPORT_SECTION_STAGE(function, stage, level_num) \
+    __used __section(".xf_auto_init_" XSTR(stage) "." XSTR(level_num)) \
+    __attribute__((aligned(__alignof__(xf_init_section_desc_t)))) \
+    const xf_init_section_desc_t __xf_init_##stage##_##function = { \
         .func       = (function), \
         .func_name  = XSTR(function), \
+        .level      = (level_num), \
     }
 
 /**
@@ -92,7 +216,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_SETUP(function)      XF_INIT_EXPORT_SECTION(function, "1")
+#define XF_INIT_EXPORT_SECTION_SETUP(function)      XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_SETUP)
 
 /**
  * @brief 板级初始化.
@@ -101,7 +225,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_BOARD(function)      XF_INIT_EXPORT_SECTION(function, "2")
+#define XF_INIT_EXPORT_SECTION_BOARD(function)      XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_BOARD)
 
 /**
  * @brief 组件预初始化 (pure software initialization).
@@ -110,7 +234,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_PREV(function)       XF_INIT_EXPORT_SECTION(function, "3")
+#define XF_INIT_EXPORT_SECTION_PREV(function)       XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_PREV)
 
 /**
  * @brief 板级初始化.
@@ -119,7 +243,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_CLEANUP(function)      XF_INIT_EXPORT_SECTION(function, "4")
+#define XF_INIT_EXPORT_SECTION_CLEANUP(function)      XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_CLEANUP)
 
 /**
  * @brief 设备初始化.
@@ -128,7 +252,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_DEVICE(function)     XF_INIT_EXPORT_SECTION(function, "5")
+#define XF_INIT_EXPORT_SECTION_DEVICE(function)     XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_DEVICE)
 
 /**
  * @brief 组件初始化 (dfs, lwip, ...).
@@ -137,7 +261,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_COMPONENT(function)  XF_INIT_EXPORT_SECTION(function, "6")
+#define XF_INIT_EXPORT_SECTION_COMPONENT(function)  XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_COMPONENT)
 
 /**
  * @brief 环境初始化 (mount disk, ...).
@@ -146,7 +270,7 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_ENV(function)        XF_INIT_EXPORT_SECTION(function, "7")
+#define XF_INIT_EXPORT_SECTION_ENV(function)        XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_ENV)
 
 /**
  * @brief 应用程序初始化 (gui application etc ...).
@@ -155,7 +279,50 @@ void xf_init_from_section(void);
  *
  * @param function 初始化函数.
  */
-#define XF_INIT_EXPORT_SECTION_APP(function)        XF_INIT_EXPORT_SECTION(function, "8")
+#define XF_INIT_EXPORT_SECTION_APP(function)        XF_INIT_EXPORT_SECTION(function, XF_INIT_LEVEL_APP)
+
+/**
+ * @brief 挂起函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_SUSPEND.
+ *
+ * @param function 挂起函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_SECTION_SUSPEND(function, level) \
+    XF_INIT_EXPORT_SECTION_STAGE(function, suspend, XF_INIT_LEVEL_##level)
+
+/**
+ * @brief 恢复函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_RESUME.
+ *
+ * @param function 恢复函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_SECTION_RESUME(function, level) \
+    XF_INIT_EXPORT_SECTION_STAGE(function, resume, XF_INIT_LEVEL_##level)
+
+/**
+ * @brief fork 后重新初始化函数.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_POSTFORK.
+ *
+ * @param function fork 后重新初始化函数.
+ * @param level 等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_SECTION_POSTFORK(function, level) \
+    XF_INIT_EXPORT_SECTION_STAGE(function, postfork, XF_INIT_LEVEL_##level)
+
+/**
+ * @brief 预热函数, 等级固定为 APP.
+ *
+ * @attention 不要直接使用该宏. 请使用 @ref XF_INIT_EXPORT_WARMUP.
+ *
+ * @param function 预热函数.
+ */
+#define XF_INIT_EXPORT_SECTION_WARMUP(function) \
+    XF_INIT_EXPORT_SECTION_STAGE(function, warmup, XF_INIT_LEVEL_APP)
 
 #ifdef __cplusplus
 } /* extern "C" */
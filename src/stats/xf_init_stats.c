@@ -0,0 +1,173 @@
+/**
+ * @file xf_init_stats.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化 / 挂起 / 恢复函数的耗时统计。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init_stats.h"
+
+#if XF_INIT_ENABLE_STATS
+
+#include <stdio.h>
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "stats"
+
+#define XF_INIT_STATS_LINE_SIZE         256
+
+/* 并发执行的线程池与后台重试、预热线程会与启动线程 (或应用) 同时记录 */
+#define XF_INIT_STATS_CONCURRENT        (XF_INIT_USE_PARALLEL || XF_INIT_ENABLE_RETRY || XF_INIT_ENABLE_WARMUP)
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_init_stat_t s_stats[XF_INIT_STATS_MAX_ENTRIES];
+static bool s_stats_ready[XF_INIT_STATS_MAX_ENTRIES];  /*!< 记录已写完, 读者只看到写完的前缀 */
+static size_t s_stats_count = 0;                        /*!< 已分配的序号, 可能大于 MAX */
+
+static const char *const s_stage_name[XF_INIT_STAGE_MAX] = {
+    [XF_INIT_STAGE_INIT]        = "init",
+    [XF_INIT_STAGE_SUSPEND]     = "suspend",
+    [XF_INIT_STAGE_RESUME]      = "resume",
+    [XF_INIT_STAGE_POSTFORK]    = "postfork",
+    [XF_INIT_STAGE_WARMUP]      = "warmup",
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+size_t xf_init_stats_count(void)
+{
+    size_t count = __atomic_load_n(&s_stats_count, __ATOMIC_RELAXED);
+    size_t i;
+
+    if (count > XF_INIT_STATS_MAX_ENTRIES) {
+        count = XF_INIT_STATS_MAX_ENTRIES;
+    }
+    /* 其他线程可能正在写后面的记录, 只返回已写完的连续部分 */
+    for (i = 0; (i < count) && __atomic_load_n(&s_stats_ready[i], __ATOMIC_ACQUIRE); i++) {
+    }
+    return i;
+}
+
+const xf_init_stat_t *xf_init_stats_get(size_t index)
+{
+    if (index >= xf_init_stats_count()) {
+        return NULL;
+    }
+    return &s_stats[index];
+}
+
+uint64_t xf_init_stats_stage_time_us(xf_init_stage_t stage)
+{
+    uint64_t total = 0;
+    size_t count = xf_init_stats_count();
+    for (size_t i = 0; i < count; i++) {
+        if (s_stats[i].stage == stage) {
+            total += s_stats[i].time_us;
+        }
+    }
+    return total;
+}
+
+void xf_init_stats_reset(void)
+{
+    size_t i;
+    for (i = 0; i < XF_INIT_STATS_MAX_ENTRIES; i++) {
+        __atomic_store_n(&s_stats_ready[i], false, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&s_stats_count, 0, __ATOMIC_RELEASE);
+}
+
+void xf_init_stats_dump(void)
+{
+    size_t count = xf_init_stats_count();
+    for (size_t i = 0; i < count; i++) {
+        const xf_init_stat_t *p_stat = &s_stats[i];
+        XF_LOGI(TAG, "%-8s L%u [ret: %d] %8u us  %s",
+                s_stage_name[p_stat->stage], (unsigned)p_stat->level,
+                p_stat->result, (unsigned)p_stat->time_us, p_stat->func_name);
+#if XF_INIT_ENABLE_PERF_COUNTERS
+        for (unsigned j = 0; j < XF_INIT_PERF_MAX; j++) {
+            if (p_stat->perf.valid_mask & (1u << j)) {
+                XF_LOGI(TAG, "    %-16s %12llu", xf_init_perf_name((xf_init_perf_counter_t)j),
+                        (unsigned long long)p_stat->perf.value[j]);
+            }
+        }
+#endif
+    }
+    count = __atomic_load_n(&s_stats_count, __ATOMIC_RELAXED);
+    if (count > XF_INIT_STATS_MAX_ENTRIES) {
+        XF_LOGW(TAG, "%u records dropped, increase XF_INIT_STATS_MAX_ENTRIES.",
+                (unsigned)(count - XF_INIT_STATS_MAX_ENTRIES));
+    }
+}
+
+void xf_init_stats_export(xf_init_stats_output_t output, void *user_data)
+{
+    char line[XF_INIT_STATS_LINE_SIZE];
+    size_t count = xf_init_stats_count();
+    int len;
+
+    if (NULL == output) {
+        return;
+    }
+
+    len = snprintf(line, sizeof(line), "stage,level,name,result,start_us,time_us");
+#if XF_INIT_ENABLE_PERF_COUNTERS
+    for (unsigned j = 0; j < XF_INIT_PERF_MAX; j++) {
+        len += snprintf(line + len, sizeof(line) - (size_t)len, ",%s",
+                        xf_init_perf_name((xf_init_perf_counter_t)j));
+    }
+#endif
+    output(line, user_data);
+
+    for (size_t i = 0; i < count; i++) {
+        const xf_init_stat_t *p_stat = &s_stats[i];
+        len = snprintf(line, sizeof(line), "%s,%u,\"%s\",%d,%llu,%u",
+                       s_stage_name[p_stat->stage], (unsigned)p_stat->level, p_stat->func_name,
+                       p_stat->result, (unsigned long long)p_stat->start_us, (unsigned)p_stat->time_us);
+#if XF_INIT_ENABLE_PERF_COUNTERS
+        for (unsigned j = 0; (j < XF_INIT_PERF_MAX) && (len > 0) && ((size_t)len < sizeof(line)); j++) {
+            if (p_stat->perf.valid_mask & (1u << j)) {
+                len += snprintf(line + len, sizeof(line) - (size_t)len, ",%llu",
+                                (unsigned long long)p_stat->perf.value[j]);
+            } else {
+                len += snprintf(line + len, sizeof(line) - (size_t)len, ",");
+            }
+        }
+#endif
+        UNUSED(len);
+        output(line, user_data);
+    }
+}
+
+void xf_init_stats_record(const xf_init_stat_t *p_stat)
+{
+#if XF_INIT_STATS_CONCURRENT
+    size_t index = __atomic_fetch_add(&s_stats_count, 1, __ATOMIC_RELAXED);
+#else
+    size_t index = s_stats_count++;
+#endif
+    /* 先写完记录再发布, 读者 (xf_init_stats_count) 不会看到写了一半的记录 */
+    if (index < XF_INIT_STATS_MAX_ENTRIES) {
+        s_stats[index] = *p_stat;
+        __atomic_store_n(&s_stats_ready[index], true, __ATOMIC_RELEASE);
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+#endif /* XF_INIT_ENABLE_STATS */
@@ -0,0 +1,130 @@
+/**
+ * @file xf_init_stats.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化 / 挂起 / 恢复函数的耗时统计。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_STATS_H__
+#define __XF_INIT_STATS_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "../perf/xf_init_perf.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_STATS || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_stats stats
+ * @brief 每个函数的耗时与返回值统计。需要开启 `XF_INIT_ENABLE_STATS`.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 导出统计记录时的输出函数.
+ *
+ * @param line 一行文本, 不含换行符.
+ * @param user_data 用户数据.
+ */
+typedef void (*xf_init_stats_output_t)(const char *line, void *user_data);
+
+/**
+ * @brief 单个函数的统计记录.
+ */
+typedef struct _xf_init_stat_t {
+    const char *func_name;                  /*!< 函数名 */
+    uint8_t stage;                          /*!< 阶段, 见 @ref xf_init_stage_t */
+    uint8_t level;                          /*!< 等级, 见 XF_INIT_LEVEL_* */
+    int result;                             /*!< 返回值 */
+    uint64_t start_us;                      /*!< 开始时间戳 */
+    uint32_t time_us;                       /*!< 耗时 */
+#if XF_INIT_ENABLE_PERF_COUNTERS || defined(__DOXYGEN__)
+    xf_init_perf_sample_t perf;             /*!< 性能计数器增量, 需要开启 `XF_INIT_ENABLE_PERF_COUNTERS` */
+#endif
+} xf_init_stat_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 获取统计记录条数.
+ *
+ * 后台线程 (重试、预热) 可能正在写入的记录不计入, 返回的记录都已写完.
+ *
+ * @return size_t 条数.
+ */
+size_t xf_init_stats_count(void);
+
+/**
+ * @brief 获取一条统计记录, 按函数完成的先后排列.
+ *
+ * @param index 序号, 范围 0 ~ count - 1.
+ * @return const xf_init_stat_t* 记录, 越界时为 NULL.
+ */
+const xf_init_stat_t *xf_init_stats_get(size_t index);
+
+/**
+ * @brief 统计某一阶段所有函数的累计耗时.
+ *
+ * @param stage 阶段.
+ * @return uint64_t 累计耗时 (us).
+ */
+uint64_t xf_init_stats_stage_time_us(xf_init_stage_t stage);
+
+/**
+ * @brief 清空统计记录. 如每次挂起前调用, 使记录只包含本次唤醒.
+ */
+void xf_init_stats_reset(void);
+
+/**
+ * @brief 以日志形式输出所有统计记录.
+ */
+void xf_init_stats_dump(void);
+
+/**
+ * @brief 以 CSV 格式导出所有统计记录, 供主机端工具 (如 tools/xf_init_plan.py) 分析.
+ *
+ * 第一行为表头 `stage,level,name,result,start_us,time_us`, 开启 `XF_INIT_ENABLE_PERF_COUNTERS` 时
+ * 追加各计数器列, 无效的计数器留空. 函数名总是带双引号.
+ *
+ * @param output 输出函数, 每行调用一次.
+ * @param user_data 传给 output 的用户数据.
+ */
+void xf_init_stats_export(xf_init_stats_output_t output, void *user_data);
+
+/**
+ * @brief （内部函数）追加一条统计记录, 可在多个线程中同时调用.
+ *
+ * @param p_stat 记录.
+ */
+void xf_init_stats_record(const xf_init_stat_t *p_stat);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_stats
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_STATS */
+
+#endif /* __XF_INIT_STATS_H__ */
@@ -0,0 +1,290 @@
+/**
+ * @file xf_init_warmup.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化完成后在后台以低优先级执行的预热阶段。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "xf_init_warmup.h"
+#include "../section/xf_init_section.h"
+#include "../registry/xf_init_registry.h"
+
+#if XF_INIT_ENABLE_WARMUP
+
+#if XF_INIT_WARMUP_USE_THREAD
+#   include <pthread.h>
+#   include <sched.h>
+#   include <time.h>
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "warmup"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void xf_init_warmup_execute(void);
+static void xf_init_warmup_finish(xf_init_warmup_state_t state);
+
+#if XF_INIT_WARMUP_USE_THREAD
+static void *xf_init_warmup_worker(void *arg);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static uint8_t s_state = XF_INIT_WARMUP_STATE_IDLE;
+static bool s_cancel = false;
+static bool s_stopped = false;                  /*!< 有函数因取消或超出预算未执行 */
+static bool s_finished = false;                 /*!< 已结束且回调已返回 */
+static uint64_t s_start_us = 0;
+static xf_init_warmup_cb_t s_cb = NULL;
+static void *s_cb_user_data = NULL;
+
+#if XF_INIT_WARMUP_USE_THREAD
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond_done = PTHREAD_COND_INITIALIZER;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+#if XF_INIT_WARMUP_USE_THREAD
+#   define xf_init_warmup_lock()    pthread_mutex_lock(&s_lock)
+#   define xf_init_warmup_unlock()  pthread_mutex_unlock(&s_lock)
+#else
+#   define xf_init_warmup_lock()
+#   define xf_init_warmup_unlock()
+#endif
+
+#define xf_init_warmup_ended(state) ((state) >= XF_INIT_WARMUP_STATE_DONE)
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_init_warmup_start(void)
+{
+#if XF_INIT_WARMUP_USE_THREAD
+    pthread_t thread;
+
+    xf_init_warmup_lock();
+    if (s_state != XF_INIT_WARMUP_STATE_IDLE) {
+        xf_init_warmup_unlock();
+        return XF_ERR_INVALID_STATE;
+    }
+    __atomic_store_n(&s_state, XF_INIT_WARMUP_STATE_RUNNING, __ATOMIC_RELEASE);
+    if (pthread_create(&thread, NULL, xf_init_warmup_worker, NULL) != 0) {
+        __atomic_store_n(&s_state, XF_INIT_WARMUP_STATE_IDLE, __ATOMIC_RELEASE);
+        xf_init_warmup_unlock();
+        XF_LOGE(TAG, "failed to start warm-up thread.");
+        return XF_FAIL;
+    }
+    pthread_detach(thread);
+    xf_init_warmup_unlock();
+    return XF_OK;
+#else
+    return XF_ERR_NOT_SUPPORTED;
+#endif
+}
+
+xf_err_t xf_init_warmup_run(void)
+{
+    xf_init_warmup_lock();
+    if (s_state != XF_INIT_WARMUP_STATE_IDLE) {
+        xf_init_warmup_unlock();
+        return XF_ERR_INVALID_STATE;
+    }
+    __atomic_store_n(&s_state, XF_INIT_WARMUP_STATE_RUNNING, __ATOMIC_RELEASE);
+    xf_init_warmup_unlock();
+
+    xf_init_warmup_execute();
+    return XF_OK;
+}
+
+void xf_init_warmup_cancel(void)
+{
+    __atomic_store_n(&s_cancel, true, __ATOMIC_RELEASE);
+}
+
+bool xf_init_warmup_should_stop(void)
+{
+    if (__atomic_load_n(&s_cancel, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+#if XF_INIT_WARMUP_BUDGET_MS > 0
+    if (xf_init_dispatch_time_us() - s_start_us >= (uint64_t)XF_INIT_WARMUP_BUDGET_MS * 1000u) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+xf_err_t xf_init_warmup_wait(uint32_t timeout_ms)
+{
+    xf_err_t err = XF_OK;
+
+    xf_init_warmup_lock();
+    if (s_state == XF_INIT_WARMUP_STATE_IDLE) {
+        err = XF_ERR_INVALID_STATE;
+    }
+#if XF_INIT_WARMUP_USE_THREAD
+    if (timeout_ms == 0) {
+        while ((err == XF_OK) && !s_finished) {
+            pthread_cond_wait(&s_cond_done, &s_lock);
+        }
+    } else {
+        struct timespec ts;
+        uint64_t ns;
+        /* 条件变量默认使用 CLOCK_REALTIME */
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ns = (uint64_t)ts.tv_nsec + (uint64_t)timeout_ms * 1000000u;
+        ts.tv_sec += (time_t)(ns / 1000000000u);
+        ts.tv_nsec = (long)(ns % 1000000000u);
+        while ((err == XF_OK) && !s_finished) {
+            if (pthread_cond_timedwait(&s_cond_done, &s_lock, &ts) != 0) {
+                err = s_finished ? XF_OK : XF_ERR_TIMEOUT;
+                break;
+            }
+        }
+    }
+#else
+    /* 没有后台线程时预热在 xf_init_warmup_run 中同步完成, 这里只能看到结束或未开始 */
+    UNUSED(timeout_ms);
+    if ((err == XF_OK) && !s_finished) {
+        err = XF_ERR_TIMEOUT;
+    }
+#endif
+    xf_init_warmup_unlock();
+
+    return err;
+}
+
+xf_init_warmup_state_t xf_init_warmup_state(void)
+{
+    return (xf_init_warmup_state_t)__atomic_load_n(&s_state, __ATOMIC_ACQUIRE);
+}
+
+bool xf_init_is_warm(void)
+{
+    xf_init_warmup_state_t state = xf_init_warmup_state();
+    return (state == XF_INIT_WARMUP_STATE_DONE) || (state == XF_INIT_WARMUP_STATE_BUDGET);
+}
+
+void xf_init_warmup_set_callback(xf_init_warmup_cb_t cb, void *user_data)
+{
+    xf_init_warmup_state_t state;
+
+    xf_init_warmup_lock();
+    s_cb = cb;
+    s_cb_user_data = user_data;
+    state = (xf_init_warmup_state_t)s_state;
+    xf_init_warmup_unlock();
+
+    if (cb && xf_init_warmup_ended(state)) {
+        cb(state, user_data);
+    }
+}
+
+bool xf_init_warmup_call(uint8_t level, int (*func)(void), const char *func_name)
+{
+    if (xf_init_warmup_should_stop()) {
+        s_stopped = true;
+        return false;
+    }
+    xf_init_dispatch_call(XF_INIT_STAGE_WARMUP, level, func, func_name);
+    return true;
+}
+
+void xf_init_warmup_atfork_child(void)
+{
+#if XF_INIT_WARMUP_USE_THREAD
+    s_lock = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    s_cond_done = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+#endif
+    /* 预热线程不会出现在子进程中; 已经预热完的状态 (缓存等) 随内存一起继承 */
+    if (s_state == XF_INIT_WARMUP_STATE_RUNNING) {
+        s_state = XF_INIT_WARMUP_STATE_IDLE;
+        s_cancel = false;
+        s_stopped = false;
+        s_finished = false;
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void xf_init_warmup_execute(void)
+{
+    xf_init_warmup_state_t state;
+
+    s_start_us = xf_init_dispatch_time_us();
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
+    xf_init_warmup_from_registry();
+#elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+    xf_init_warmup_from_section();
+#endif
+
+    if (__atomic_load_n(&s_cancel, __ATOMIC_ACQUIRE)) {
+        state = XF_INIT_WARMUP_STATE_CANCELLED;
+    } else if (s_stopped) {
+        state = XF_INIT_WARMUP_STATE_BUDGET;
+    } else {
+        state = XF_INIT_WARMUP_STATE_DONE;
+    }
+    XF_LOGD(TAG, "warm-up ended [state: %d] in %u ms.", (int)state,
+            (unsigned)((xf_init_dispatch_time_us() - s_start_us) / 1000u));
+    xf_init_warmup_finish(state);
+}
+
+static void xf_init_warmup_finish(xf_init_warmup_state_t state)
+{
+    xf_init_warmup_cb_t cb;
+    void *user_data;
+
+    xf_init_warmup_lock();
+    __atomic_store_n(&s_state, (uint8_t)state, __ATOMIC_RELEASE);
+    cb = s_cb;
+    user_data = s_cb_user_data;
+    xf_init_warmup_unlock();
+
+    if (cb) {
+        cb(state, user_data);
+    }
+
+    /* 回调返回后才唤醒等待者, 等待返回时回调中的工作 (如通知负载均衡) 已经完成 */
+    xf_init_warmup_lock();
+    s_finished = true;
+#if XF_INIT_WARMUP_USE_THREAD
+    pthread_cond_broadcast(&s_cond_done);
+#endif
+    xf_init_warmup_unlock();
+}
+
+#if XF_INIT_WARMUP_USE_THREAD
+
+static void *xf_init_warmup_worker(void *arg)
+{
+    UNUSED(arg);
+#if defined(__linux__) && defined(SCHED_IDLE)
+    /* 只在其他线程都空闲时运行, 不与正在处理的请求争抢 CPU */
+    struct sched_param param = { 0 };
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        XF_LOGW(TAG, "failed to set SCHED_IDLE, warm up at normal priority.");
+    }
+#endif
+    xf_init_warmup_execute();
+    return NULL;
+}
+
+#endif /* XF_INIT_WARMUP_USE_THREAD */
+
+#endif /* XF_INIT_ENABLE_WARMUP */
@@ -0,0 +1,162 @@
+/**
+ * @file xf_init_warmup.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 初始化完成后在后台以低优先级执行的预热阶段。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_WARMUP_H__
+#define __XF_INIT_WARMUP_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_WARMUP || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_warmup warmup
+ * @brief 所有等级执行完后, 服务虽然可用, 但缓存、页表、延迟构建的表仍是冷的.
+ * 用 `XF_INIT_EXPORT_WARMUP` 导出的预热函数在后台以最低优先级按注册顺序执行,
+ * 结束后通过 @ref xf_init_is_warm 或回调通知 (如告知负载均衡已达到全速).
+ * 需要开启 `XF_INIT_ENABLE_WARMUP`.
+ *
+ * - `XF_INIT_WARMUP_AUTO_START` 为 1 时 xf_init 执行完所有等级后自动开始;
+ * - 总耗时超过 `XF_INIT_WARMUP_BUDGET_MS` 后不再执行剩余的函数;
+ * - @ref xf_init_warmup_cancel 取消, 正在执行的函数可以用 @ref xf_init_warmup_should_stop 提前返回;
+ * - POSIX 上由后台线程执行 (Linux 上为 SCHED_IDLE), 其他平台在空闲任务中调用 @ref xf_init_warmup_run.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 预热状态.
+ */
+typedef enum _xf_init_warmup_state_t {
+    XF_INIT_WARMUP_STATE_IDLE = 0x00,       /*!< 尚未开始 */
+    XF_INIT_WARMUP_STATE_RUNNING,           /*!< 正在执行 */
+    XF_INIT_WARMUP_STATE_DONE,              /*!< 全部执行完 */
+    XF_INIT_WARMUP_STATE_BUDGET,            /*!< 超出时间预算, 剩余的函数未执行 */
+    XF_INIT_WARMUP_STATE_CANCELLED,         /*!< 已取消 */
+} xf_init_warmup_state_t;
+
+/**
+ * @brief 预热结束时调用.
+ *
+ * @param state 结束时的状态, DONE / BUDGET / CANCELLED.
+ * @param user_data 用户数据.
+ */
+typedef void (*xf_init_warmup_cb_t)(xf_init_warmup_state_t state, void *user_data);
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 在后台线程中开始预热.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_NOT_SUPPORTED      没有后台线程, 需调用 @ref xf_init_warmup_run
+ *      - XF_ERR_INVALID_STATE      已经开始过
+ *      - XF_FAIL                   无法创建线程
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_warmup_start(void);
+
+/**
+ * @brief 在当前线程中执行预热, 直到结束.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      已经开始过
+ *      - XF_OK                     成功 (结束状态见 @ref xf_init_warmup_state)
+ */
+xf_err_t xf_init_warmup_run(void);
+
+/**
+ * @brief 取消预热. 正在执行的函数执行完后停止, 剩余的函数不再执行.
+ */
+void xf_init_warmup_cancel(void);
+
+/**
+ * @brief 预热函数中周期调用, 返回 true 时应尽快返回 (已取消或超出预算).
+ *
+ * @return bool
+ */
+bool xf_init_warmup_should_stop(void);
+
+/**
+ * @brief 等待预热结束, 返回时结束回调 (如有) 已经返回.
+ *
+ * @param timeout_ms 超时时间, 0 表示一直等待.
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      尚未开始
+ *      - XF_ERR_TIMEOUT            超时
+ *      - XF_OK                     已结束
+ */
+xf_err_t xf_init_warmup_wait(uint32_t timeout_ms);
+
+/**
+ * @brief 获取预热状态.
+ *
+ * @return xf_init_warmup_state_t
+ */
+xf_init_warmup_state_t xf_init_warmup_state(void);
+
+/**
+ * @brief 是否已预热完毕, 即所有预热函数已执行 (DONE) 或时间预算已用完 (BUDGET).
+ *
+ * @return bool
+ */
+bool xf_init_is_warm(void);
+
+/**
+ * @brief 设置预热结束时的回调. 已经结束时立即在当前线程中调用.
+ *
+ * @param cb 回调, NULL 表示取消.
+ * @param user_data 传给回调的用户数据.
+ */
+void xf_init_warmup_set_callback(xf_init_warmup_cb_t cb, void *user_data);
+
+/**
+ * @brief （内部函数）执行一个预热函数. 由各实现方式遍历预热函数时调用.
+ *
+ * @param level 等级.
+ * @param func 预热函数.
+ * @param func_name 函数名.
+ * @return bool 是否继续执行下一个.
+ */
+bool xf_init_warmup_call(uint8_t level, int (*func)(void), const char *func_name);
+
+/**
+ * @brief （内部函数）fork 之后在子进程中调用. 父进程中正在进行的预热在子进程中回到未开始的状态.
+ */
+void xf_init_warmup_atfork_child(void);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_warmup
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_WARMUP */
+
+#endif /* __XF_INIT_WARMUP_H__ */
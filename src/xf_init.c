@@ -17,28 +17,149 @@
 
 #define TAG "xf_init"
 
+#define XF_INIT_LEVEL_BIT(level)        (1u << (level))
+#define XF_INIT_LEVEL_ALL               (XF_INIT_LEVEL_BIT(XF_INIT_LEVEL_APP + 1) - XF_INIT_LEVEL_BIT(XF_INIT_LEVEL_SETUP))
+
 /* ==================== [Typedefs] ========================================== */
 
 /* ==================== [Static Prototypes] ================================= */
 
 /* ==================== [Static Variables] ================================== */
 
+static bool s_suspended = false;
+static uint16_t s_done_levels = 0;
+static bool s_released = false;
+
 /* ==================== [Macros] ============================================ */
 
 /* ==================== [Global Functions] ================================== */
 
 xf_err_t xf_init(void)
 {
+    xf_err_t err = xf_init_levels(XF_INIT_LEVEL_SETUP, XF_INIT_LEVEL_APP);
+
+    XF_LOGD(TAG, "Auto initialization is complete.");
+
+    return err;
+}
+
+xf_err_t xf_init_levels(uint8_t first, uint8_t last)
+{
+    if ((first < XF_INIT_LEVEL_SETUP) || (last > XF_INIT_LEVEL_APP) || (first > last)) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (s_released) {
+        return XF_ERR_INVALID_STATE;
+    }
 
 #if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
-    xf_init_from_registry();
+    xf_init_levels_from_registry(first, last);
 #elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
-    xf_init_from_section();
+    xf_init_levels_from_section(first, last);
 #endif
 
-    XF_LOGD(TAG, "Auto initialization is complete.");
+    s_done_levels |= (uint16_t)(XF_INIT_LEVEL_BIT(last + 1) - XF_INIT_LEVEL_BIT(first));
+
+#if XF_INIT_ENABLE_ARENA && XF_INIT_ARENA_SEAL_AFTER_INIT
+    if (s_done_levels == XF_INIT_LEVEL_ALL) {
+        xf_init_arena_seal();
+    }
+#endif
+#if XF_INIT_ENABLE_WARMUP && XF_INIT_WARMUP_AUTO_START
+    /* 所有等级都已执行, 预热只在第一次完成时开始 */
+    if ((s_done_levels == XF_INIT_LEVEL_ALL)
+            && (xf_init_warmup_state() == XF_INIT_WARMUP_STATE_IDLE)) {
+        xf_init_warmup_start();
+    }
+#endif
 
     return XF_OK;
 }
 
+#if XF_INIT_ENABLE_RELEASE
+xf_err_t xf_init_release(void)
+{
+    size_t size;
+
+    if (s_released || (s_done_levels != XF_INIT_LEVEL_ALL)) {
+        return XF_ERR_INVALID_STATE;
+    }
+    s_released = true;
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
+    xf_init_registry_release();
+#endif
+    size = xf_init_release_sections();
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+    size += xf_init_section_release();
+#endif
+
+    XF_LOGD(TAG, "Released %u bytes of init code and data.", (unsigned)size);
+
+    return XF_OK;
+}
+#endif
+
+xf_err_t xf_suspend(void)
+{
+    xf_err_t err = XF_OK;
+
+    if (s_suspended) {
+        return XF_ERR_INVALID_STATE;
+    }
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
+    err = xf_init_suspend_from_registry();
+#elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+    err = xf_init_suspend_from_section();
+#endif
+
+    /* 挂起失败时部分函数可能已挂起, 仍视为挂起状态, 以便调用 xf_resume 回滚 */
+    s_suspended = true;
+    XF_LOGD(TAG, "Suspend is complete [err: %d].", (int)err);
+
+    return err;
+}
+
+xf_err_t xf_resume(void)
+{
+    xf_err_t err = XF_OK;
+    uint64_t start_us = xf_init_dispatch_time_us();
+
+    if (!s_suspended) {
+        return XF_ERR_INVALID_STATE;
+    }
+    UNUSED(start_us);
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
+    err = xf_init_resume_from_registry();
+#elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+    err = xf_init_resume_from_section();
+#endif
+
+    s_suspended = false;
+    XF_LOGD(TAG, "Resume is complete [err: %d] in %u us.", (int)err,
+            (unsigned)(xf_init_dispatch_time_us() - start_us));
+
+    return err;
+}
+
+xf_err_t xf_init_postfork(void)
+{
+    xf_err_t err = XF_OK;
+
+    /* 父进程的线程不会出现在子进程中, 线程池需要丢弃后重建 */
+    xf_init_dispatch_atfork_child();
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
+    err = xf_init_postfork_from_registry();
+#elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+    err = xf_init_postfork_from_section();
+#endif
+
+    XF_LOGD(TAG, "Postfork is complete [err: %d].", (int)err);
+
+    return err;
+}
+
 /* ==================== [Static Functions] ================================== */
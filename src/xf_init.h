@@ -47,6 +47,18 @@
 
 #include "section/xf_init_section.h"
 #include "registry/xf_init_registry.h"
+#include "stats/xf_init_stats.h"
+#include "zygote/xf_init_zygote.h"
+#include "profile/xf_init_profile.h"
+#include "arena/xf_init_arena.h"
+#include "coro/xf_init_coro.h"
+#include "warmup/xf_init_warmup.h"
+#include "once/xf_init_once.h"
+#include "percpu/xf_init_percpu.h"
+#include "array/xf_init_array.h"
+#include "resource/xf_init_resource.h"
+#include "release/xf_init_release.h"
+#include "retry/xf_init_retry.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -74,6 +86,74 @@ extern "C" {
  */
 xf_err_t xf_init(void);
 
+/**
+ * @brief 只调用 [first, last] 等级范围内的初始化函数.
+ *
+ * 用于把初始化拆成多段执行, 如 zygote 在 fork 前只执行到某一等级.
+ * 每个等级只应被执行一次, @ref xf_init 等价于 `xf_init_levels(XF_INIT_LEVEL_SETUP, XF_INIT_LEVEL_APP)`.
+ *
+ * @param first 起始等级, 见 XF_INIT_LEVEL_*.
+ * @param last 结束等级 (包含).
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_ARG        等级范围无效
+ *      - XF_ERR_INVALID_STATE      已调用 xf_init_release
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_levels(uint8_t first, uint8_t last);
+
+#if XF_INIT_ENABLE_RELEASE || defined(__DOXYGEN__)
+/**
+ * @brief 所有等级执行完后回收 `__xf_init` / `__xf_initdata` / `__xf_initconst` 标记的代码与数据,
+ * 以及初始化函数的描述符 (constructor / registry 模式下还有链表节点).
+ *
+ * 用于不会再次初始化的长期运行进程. 回收后 @ref xf_init_levels 不能再调用,
+ * @ref xf_init_profile_is_enabled 也不再能查到初始化函数.
+ * 挂起 / 恢复 / fork 后重新初始化不受影响. 需要开启 `XF_INIT_ENABLE_RELEASE`.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      还有等级未执行, 或已经回收
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_release(void);
+#endif
+
+/**
+ * @brief 挂起. 按等级从高到低 (APP -> SETUP) 调用所有挂起函数.
+ *
+ * 某个挂起函数返回非 0 时立即停止, 由调用者决定是否调用 @ref xf_resume 回滚.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      已经处于挂起状态
+ *      - XF_FAIL                   某个挂起函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_suspend(void);
+
+/**
+ * @brief 恢复. 按等级从低到高 (SETUP -> APP) 调用所有恢复函数.
+ *
+ * 开启 `XF_INIT_ENABLE_PARALLEL_RESUME` 时同一等级内的恢复函数并发执行.
+ * 某个恢复函数失败不会影响其他恢复函数.
+ *
+ * @return xf_err_t
+ *      - XF_ERR_INVALID_STATE      未处于挂起状态
+ *      - XF_FAIL                   某个恢复函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_resume(void);
+
+/**
+ * @brief fork 之后在子进程中调用, 按等级从低到高调用所有 fork 后的重新初始化函数.
+ *
+ * 用于重新打开父进程中不能共享的资源 (随机数种子、连接、线程等).
+ * 某个函数失败不会影响其他函数.
+ *
+ * @return xf_err_t
+ *      - XF_FAIL                   某个函数失败
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_postfork(void);
+
 /**
  * End of addtogroup group_xf_init_port
  * @}
@@ -187,6 +267,69 @@ xf_err_t xf_init(void);
  */
 #define XF_INIT_EXPORT_APP(function)
 
+/**
+ * @brief 挂起函数. 由 @ref xf_suspend 按等级从高到低调用.
+ *
+ * 根据实际配置见:
+ * - @ref XF_INIT_EXPORT_SECTION_SUSPEND
+ * - @ref XF_INIT_EXPORT_REGISTRY_SUSPEND
+ *
+ * @param function 挂起函数, 类型与初始化函数相同.
+ * @param level 所属等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_SUSPEND(function, level)
+
+/**
+ * @brief 恢复函数. 由 @ref xf_resume 按等级从低到高调用.
+ *
+ * 根据实际配置见:
+ * - @ref XF_INIT_EXPORT_SECTION_RESUME
+ * - @ref XF_INIT_EXPORT_REGISTRY_RESUME
+ *
+ * @param function 恢复函数, 类型与初始化函数相同.
+ * @param level 所属等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_RESUME(function, level)
+
+/**
+ * @brief fork 后的重新初始化函数. 由 @ref xf_init_postfork 按等级从低到高调用.
+ *
+ * 根据实际配置见:
+ * - @ref XF_INIT_EXPORT_SECTION_POSTFORK
+ * - @ref XF_INIT_EXPORT_REGISTRY_POSTFORK
+ *
+ * @param function 重新初始化函数, 类型与初始化函数相同.
+ * @param level 所属等级, 如 DEVICE.
+ */
+#define XF_INIT_EXPORT_POSTFORK(function, level)
+
+/**
+ * @brief 预热函数. 所有等级执行完后在后台按注册顺序调用, 见 @ref group_xf_init_warmup.
+ *
+ * 根据实际配置见:
+ * - @ref XF_INIT_EXPORT_SECTION_WARMUP
+ * - @ref XF_INIT_EXPORT_REGISTRY_WARMUP
+ *
+ * @param function 预热函数, 类型与初始化函数相同.
+ */
+#define XF_INIT_EXPORT_WARMUP(function)
+
+/**
+ * @brief 导出声明了资源令牌的初始化函数, 见 @ref group_xf_init_resource.
+ *
+ * 并发执行同一等级时, 所需令牌没有空余的函数会被推迟, 与其他不冲突的函数交错执行.
+ * 未开启 `XF_INIT_ENABLE_RESOURCE` 时等同于 `XF_INIT_EXPORT_<level>(function)`.
+ *
+ * 根据实际配置见:
+ * - @ref XF_INIT_EXPORT_SECTION_RESOURCE
+ * - @ref XF_INIT_EXPORT_REGISTRY_RESOURCE
+ *
+ * @param function 初始化函数.
+ * @param level 等级, 如 DEVICE.
+ * @param res 逗号分隔的资源令牌名, 如 "i2c0" 或 "i2c0,fw".
+ */
+#define XF_INIT_EXPORT_RESOURCE(function, level, res)
+
 #elif     (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
 
 #define XF_INIT_EXPORT_SETUP(function)          XF_INIT_EXPORT_SECTION_SETUP(function)
@@ -205,6 +348,20 @@ xf_err_t xf_init(void);
 
 #define XF_INIT_EXPORT_APP(function)            XF_INIT_EXPORT_SECTION_APP(function)
 
+#define XF_INIT_EXPORT_SUSPEND(function, level) XF_INIT_EXPORT_SECTION_SUSPEND(function, level)
+
+#define XF_INIT_EXPORT_RESUME(function, level)  XF_INIT_EXPORT_SECTION_RESUME(function, level)
+
+#define XF_INIT_EXPORT_POSTFORK(function, level) XF_INIT_EXPORT_SECTION_POSTFORK(function, level)
+
+#define XF_INIT_EXPORT_WARMUP(function)         XF_INIT_EXPORT_SECTION_WARMUP(function)
+
+#if XF_INIT_ENABLE_RESOURCE
+#define XF_INIT_EXPORT_RESOURCE(function, level, res) XF_INIT_EXPORT_SECTION_RESOURCE(function, level, res)
+#else
+#define XF_INIT_EXPORT_RESOURCE(function, level, res) XF_INIT_EXPORT_##level(function)
+#endif
+
 #elif   (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_REGISTRY || XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_CONSTRUCTOR)
 
 #define XF_INIT_EXPORT_SETUP(function)          XF_INIT_EXPORT_REGISTRY_SETUP(function)
@@ -222,6 +379,20 @@ xf_err_t xf_init(void);
 #define XF_INIT_EXPORT_ENV(function)            XF_INIT_EXPORT_REGISTRY_ENV(function)
 
 #define XF_INIT_EXPORT_APP(function)            XF_INIT_EXPORT_REGISTRY_APP(function)
+
+#define XF_INIT_EXPORT_SUSPEND(function, level) XF_INIT_EXPORT_REGISTRY_SUSPEND(function, level)
+
+#define XF_INIT_EXPORT_RESUME(function, level)  XF_INIT_EXPORT_REGISTRY_RESUME(function, level)
+
+#define XF_INIT_EXPORT_POSTFORK(function, level) XF_INIT_EXPORT_REGISTRY_POSTFORK(function, level)
+
+#define XF_INIT_EXPORT_WARMUP(function)         XF_INIT_EXPORT_REGISTRY_WARMUP(function)
+
+#if XF_INIT_ENABLE_RESOURCE
+#define XF_INIT_EXPORT_RESOURCE(function, level, res) XF_INIT_EXPORT_REGISTRY_RESOURCE(function, level, res)
+#else
+#define XF_INIT_EXPORT_RESOURCE(function, level, res) XF_INIT_EXPORT_##level(function)
+#endif
 #endif
 
 /**
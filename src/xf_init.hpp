@@ -0,0 +1,552 @@
+/**
+ * @file xf_init.hpp
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief xf_init 的 C++ 头文件接口（C++17 起，lambda 需要 C++20）。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ * @details 用法：
+ * @code{.cpp}
+ * static int device_test() { return 0; }
+ * static constexpr xf::init::exporter<xf::init::level::device, &device_test> s_device_test{};
+ *
+ * // C++20: 无捕获 lambda, 配合 constexpr 名称
+ * static constexpr char s_name[] = "lambda_test";
+ * static constexpr xf::init::exporter<xf::init::level::app, [] { return 0; }, s_name> s_lambda_test{};
+ *
+ * // C++20 且开启 XF_INIT_ENABLE_CORO: 协程初始化函数, 同一等级内的协程在一个事件循环中并发推进
+ * static xf::init::task modem_init() {
+ *     co_await xf::init::readable(uart_fd);
+ *     co_await xf::init::sleep_for(std::chrono::milliseconds(10));
+ *     co_return co_await xf::init::done("power_init");
+ * }
+ * static constexpr xf::init::exporter<xf::init::level::device, &modem_init> s_modem_init{};
+ * @endcode
+ *
+ * 描述符与 C 宏导出的完全相同, 落在同一个段或同一个注册表里, C 与 C++ 注册可以混用。
+ */
+
+#ifndef __XF_INIT_HPP__
+#define __XF_INIT_HPP__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_init.h"
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#if __cplusplus < 201703L
+#   error "xf_init.hpp 需要 C++17 及以上"
+#endif
+
+#if XF_INIT_ENABLE_CORO && (__cplusplus >= 202002L) && __has_include(<coroutine>)
+#   include <chrono>
+#   include <coroutine>
+#   include <utility>
+#   define XF_INIT_CPP_CORO     1
+#else
+#   define XF_INIT_CPP_CORO     0
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/*
+ * 描述符 (registry 模式下为表项) 用汇编写入段, 并加入 emit() 所在的 COMDAT 组:
+ * 多个文件实例化同一个 exporter 时, 链接器只保留一份函数和一份描述符.
+ */
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION) || XF_INIT_REGISTRY_CPP_TABLE
+#   if defined(__PIC__) || defined(__pic__)
+#       define XF_INIT_CPP_SECTION_FLAGS    "\"awG\", @progbits, %c[key], comdat"
+#   else
+#       define XF_INIT_CPP_SECTION_FLAGS    "\"aG\", @progbits, %c[key], comdat"
+#   endif
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+namespace xf {
+namespace init {
+
+/**
+ * @brief 初始化等级, 与 `XF_INIT_EXPORT_*` 宏一一对应。
+ *
+ * 数值与 section 模式下的段名后缀 ("1" ~ "8") 一致,
+ * 减一即为 registry 模式下的 `XF_INIT_REGISTRY_TYPE_*`.
+ */
+enum class level : unsigned {
+    setup       = 1,
+    board       = 2,
+    prev        = 3,
+    cleanup     = 4,
+    device      = 5,
+    component   = 6,
+    env         = 7,
+    app         = 8,
+};
+
+using fn_t = ::xf_init_fn_t;
+
+#if XF_INIT_CPP_CORO
+
+/**
+ * @brief 协程初始化函数的返回类型, 用 `co_return` 返回 int (0 表示成功).
+ *
+ * 协程在所属等级内开始执行, 第一次挂起后本等级的其他函数继续执行;
+ * 下一等级开始前, xf_init 在事件循环中把本等级的协程推进到结束.
+ * 协程只在调用 xf_init 的线程上恢复.
+ */
+class task {
+public:
+    struct promise_type {
+        ::xf_init_coro_t *p_coro = nullptr;
+        int result = 0;
+
+        task get_return_object(void) noexcept
+        {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        /* 先挂起, 由 start() 填好描述符后再开始执行 */
+        std::suspend_always initial_suspend(void) noexcept
+        {
+            return {};
+        }
+
+        auto final_suspend(void) noexcept
+        {
+            struct finisher {
+                bool await_ready(void) noexcept
+                {
+                    return false;
+                }
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    ::xf_init_coro_t *p_coro = h.promise().p_coro;
+                    int result = h.promise().result;
+                    h.destroy();
+                    ::xf_init_coro_finish(p_coro, result);
+                }
+                void await_resume(void) noexcept {}
+            };
+            return finisher{};
+        }
+
+        void return_value(int value) noexcept
+        {
+            result = value;
+        }
+
+        void unhandled_exception(void) noexcept
+        {
+            result = XF_FAIL;
+        }
+    };
+
+    task(task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    /**
+     * @brief （内部函数）开始执行, 协程帧此后由事件循环管理, 结束时自行释放.
+     */
+    void start(::xf_init_coro_t *p_coro) noexcept
+    {
+        std::coroutine_handle<promise_type> h = std::exchange(m_handle, {});
+        h.promise().p_coro = p_coro;
+        h.resume();
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace detail {
+
+/* awaiter 的公共部分: 等待节点位于协程帧内, 结束时由事件循环恢复协程 */
+struct awaiter_base {
+    ::xf_init_coro_wait_t wait = {};
+
+    static void resume(void *arg)
+    {
+        std::coroutine_handle<>::from_address(arg).resume();
+    }
+
+    void bind(std::coroutine_handle<> h) noexcept
+    {
+        wait.cb = &resume;
+        wait.arg = h.address();
+    }
+};
+
+} /* namespace detail */
+
+/**
+ * @brief `co_await sleep_for(ms)`: 等待一段时间.
+ */
+struct sleep_for : detail::awaiter_base {
+    explicit sleep_for(std::chrono::milliseconds ms) noexcept : m_ms(ms.count() > 0 ? ms.count() : 0) {}
+
+    bool await_ready(void) const noexcept
+    {
+        return m_ms == 0;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        bind(h);
+        return ::xf_init_coro_wait_timer(&wait, static_cast<uint32_t>(m_ms)) == XF_OK;
+    }
+
+    void await_resume(void) const noexcept {}
+
+private:
+    std::chrono::milliseconds::rep m_ms;
+};
+
+/**
+ * @brief `co_await wait_fd(fd, XF_INIT_CORO_READ)`: 等待 fd 就绪.
+ *
+ * `co_await` 的结果为发生的事件 (XF_INIT_CORO_READ / WRITE / ERROR), 无法等待时为 XF_ERR_*.
+ */
+struct wait_fd : detail::awaiter_base {
+    wait_fd(int fd, uint32_t events) noexcept : m_fd(fd), m_events(events) {}
+
+    bool await_ready(void) const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        xf_err_t err;
+        bind(h);
+        err = ::xf_init_coro_wait_fd(&wait, m_fd, m_events);
+        if (err != XF_OK) {
+            wait.result = err;
+            return false;
+        }
+        return true;
+    }
+
+    int await_resume(void) const noexcept
+    {
+        return wait.result;
+    }
+
+private:
+    int m_fd;
+    uint32_t m_events;
+};
+
+/**
+ * @brief `co_await readable(fd)`: 等待 fd 可读.
+ */
+inline wait_fd readable(int fd) noexcept
+{
+    return wait_fd(fd, XF_INIT_CORO_READ);
+}
+
+/**
+ * @brief `co_await writable(fd)`: 等待 fd 可写.
+ */
+inline wait_fd writable(int fd) noexcept
+{
+    return wait_fd(fd, XF_INIT_CORO_WRITE);
+}
+
+/**
+ * @brief `co_await done("name")`: 等待另一个协程初始化函数结束, 结果为它 co_return 的值.
+ *
+ * 只能等待同一等级或更低等级的协程; 普通初始化函数在更低等级时已经执行完, 不需要等待.
+ * 等待的协程不存在时结果为 XF_ERR_NOT_FOUND.
+ */
+struct done : detail::awaiter_base {
+    explicit done(const char *func_name) noexcept : m_func_name(func_name) {}
+
+    bool await_ready(void) noexcept
+    {
+        return ::xf_init_coro_status(m_func_name, &wait.result) == XF_OK;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        bind(h);
+        return ::xf_init_coro_wait_done(&wait, m_func_name) == XF_OK;
+    }
+
+    int await_resume(void) const noexcept
+    {
+        return wait.result;
+    }
+
+private:
+    const char *m_func_name;
+};
+
+#endif /* XF_INIT_CPP_CORO */
+
+namespace detail {
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+using desc_t = ::xf_init_section_desc_t;
+#else
+using desc_t = ::xf_init_registry_desc_t;
+#endif
+
+template <level L>
+constexpr bool is_valid_level = (L >= level::setup) && (L <= level::app);
+
+/* 函数指针直接入表; 其他可调用对象 (如无捕获 lambda) 由 thunk 展开, 编译期即可内联 */
+template <auto F>
+int thunk(void)
+{
+    return static_cast<int>(F());
+}
+
+/* 从 __PRETTY_FUNCTION__ 中截取 "F = xxx" 部分, 得到编译期函数名 */
+template <auto F>
+constexpr std::string_view pretty(void)
+{
+    return __PRETTY_FUNCTION__;
+}
+
+constexpr std::string_view extract_name(std::string_view pretty)
+{
+    std::size_t begin = pretty.find("F = ");
+    if (begin == std::string_view::npos) {
+        return pretty;
+    }
+    begin += 4;
+    if (pretty[begin] == '&') {
+        ++begin;
+    }
+    std::size_t end = pretty.find_first_of(";]", begin);
+    return pretty.substr(begin, end - begin);
+}
+
+template <auto F>
+struct fn_name {
+    static constexpr std::string_view view = extract_name(pretty<F>());
+
+    struct storage_t {
+        char data[view.size() + 1];
+    };
+
+    static constexpr storage_t make(void)
+    {
+        storage_t s = {};
+        for (std::size_t i = 0; i < view.size(); ++i) {
+            s.data[i] = view[i];
+        }
+        return s;
+    }
+
+    static constexpr storage_t value = make();
+};
+
+template <auto F, const char *Name>
+constexpr const char *name_of(void)
+{
+    if constexpr (Name != nullptr) {
+        return Name;
+    } else {
+        return fn_name<F>::value.data;
+    }
+}
+
+template <auto F>
+constexpr bool is_coro(void)
+{
+#if XF_INIT_CPP_CORO
+    return std::is_same_v<std::invoke_result_t<decltype(F)>, task>;
+#else
+    return false;
+#endif
+}
+
+#if XF_INIT_CPP_CORO
+/* 协程: 登记后开始执行到第一次挂起, 之后由事件循环推进; 描述符表中仍是普通的 int(void) */
+template <level L, auto F, const char *Name>
+int coro_thunk(void)
+{
+    static ::xf_init_coro_t s_coro = { name_of<F, Name>(), static_cast<uint8_t>(L), 0, 0, 0, nullptr };
+    ::xf_init_coro_begin(&s_coro);
+    F().start(&s_coro);
+    return 0;
+}
+#endif
+
+template <level L, auto F, const char *Name>
+constexpr fn_t as_fn(void)
+{
+    if constexpr (std::is_same_v<std::decay_t<decltype(F)>, fn_t>) {
+        return F;
+#if XF_INIT_CPP_CORO
+    } else if constexpr (is_coro<F>()) {
+        return &coro_thunk<L, F, Name>;
+#endif
+    } else {
+        return &thunk<F>;
+    }
+}
+
+#if (XF_INIT_IMPL_METHOD == XF_INIT_IMPL_BY_SECTION)
+
+/*
+ * GCC 会忽略模板实体上的 section 属性, 因此直接用汇编把描述符写进
+ * ".xf_auto_init.<level>" 段. 布局必须与 xf_init_section_desc_t 一致.
+ * C++ 导出的函数不声明资源令牌, 开启 XF_INIT_ENABLE_RESOURCE 时 resource 写 0.
+ */
+#if XF_INIT_ENABLE_RESOURCE
+#   define XF_INIT_CPP_DESC_WORDS       4
+#   define XF_INIT_CPP_DESC_RESOURCE    ".dc.a 0\n\t"
+#else
+#   define XF_INIT_CPP_DESC_WORDS       3
+#   define XF_INIT_CPP_DESC_RESOURCE    ""
+#endif
+static_assert(sizeof(desc_t) == XF_INIT_CPP_DESC_WORDS * sizeof(void *),
+              "xf_init_section_desc_t changed, update xf::init::detail::slot");
+
+template <level L, auto F, const char *Name>
+struct slot {
+    [[gnu::used]] static void emit(void)
+    {
+        __asm__ __volatile__(
+            ".pushsection .xf_auto_init.%c0, " XF_INIT_CPP_SECTION_FLAGS "\n\t"
+            ".balign %c1\n\t"
+            ".dc.a %c2\n\t"
+            ".dc.a %c3\n\t"
+            ".byte %c0\n\t"
+            ".balign %c1\n\t"
+            XF_INIT_CPP_DESC_RESOURCE
+            ".popsection"
+            :
+            : "i"(static_cast<unsigned>(L)), "i"(alignof(desc_t)),
+            "i"(as_fn<L, F, Name>()), "i"(name_of<F, Name>()), [key] "i"(&emit));
+    }
+
+    static constexpr auto anchor(void)
+    {
+        return &emit;
+    }
+};
+
+#elif XF_INIT_REGISTRY_CPP_TABLE
+
+/*
+ * constructor / registry 模式: 描述符是编译期常量, 表项 {描述符, 等级} 用汇编写入
+ * XF_INIT_REGISTRY_CPP_SECTION 段, 由 registry 在遍历链表后遍历, 没有运行时注册.
+ */
+static_assert(sizeof(::xf_init_registry_cpp_entry_t) == 2 * sizeof(void *),
+              "xf_init_registry_cpp_entry_t changed, update xf::init::detail::slot");
+
+template <level L, auto F, const char *Name>
+struct slot {
+#if XF_INIT_ENABLE_RESOURCE
+    static constexpr desc_t desc = { as_fn<L, F, Name>(), name_of<F, Name>(), nullptr };
+#else
+    static constexpr desc_t desc = { as_fn<L, F, Name>(), name_of<F, Name>() };
+#endif
+
+    [[gnu::used]] static void emit(void)
+    {
+        __asm__ __volatile__(
+            ".pushsection " XF_INIT_REGISTRY_CPP_SECTION ", " XF_INIT_CPP_SECTION_FLAGS "\n\t"
+            ".balign %c0\n\t"
+            ".dc.a %c1\n\t"
+            ".dc.a %c2\n\t"
+            ".popsection"
+            :
+            : "i"(alignof(::xf_init_registry_cpp_entry_t)), "i"(&desc),
+            "i"(static_cast<unsigned>(L) - 1), [key] "i"(&emit));
+    }
+
+    static constexpr auto anchor(void)
+    {
+        return &emit;
+    }
+};
+
+#else
+
+template <level L, auto F, const char *Name>
+struct slot {
+#if XF_INIT_ENABLE_RESOURCE
+    static constexpr desc_t desc = { as_fn<L, F, Name>(), name_of<F, Name>(), nullptr };
+#else
+    static constexpr desc_t desc = { as_fn<L, F, Name>(), name_of<F, Name>() };
+#endif
+
+    static ::xf_init_registry_desc_node_t node;
+
+    /* 非 ELF 工具链上没有 __start_ / __stop_ 符号, 退回 C++ 静态初始化注册 */
+    static inline const bool registered = (::xf_init_registry_register_desc_node(
+            &node, static_cast<::xf_init_registry_type_t>(static_cast<unsigned>(L) - 1)), true);
+
+    static constexpr auto anchor(void)
+    {
+        return &registered;
+    }
+};
+
+template <level L, auto F, const char *Name>
+::xf_init_registry_desc_node_t slot<L, F, Name>::node = {
+    XF_LIST_HEAD_INIT(node.node),
+    &desc,
+};
+
+#endif
+
+} /* namespace detail */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * @brief 导出初始化函数.
+ *
+ * 定义一个该类型的 constexpr 对象 (或显式实例化该模板) 即完成注册:
+ * - section 模式: 描述符在编译期写入段, 无运行时开销;
+ * - constructor / registry 模式: ELF 上表项在编译期写入 `xf_init_cpp` 段, 同样无运行时注册;
+ *   其他工具链通过 C++ 静态初始化挂入注册链表.
+ *
+ * 多个文件实例化同一个 exporter (如在头文件中导出) 时只注册一次.
+ *
+ * @tparam L 初始化等级, 见 @ref level.
+ * @tparam F 初始化函数. 可以是函数指针 (含静态成员函数、函数模板实例),
+ *           也可以是无捕获 lambda (C++20). 返回值需可转换为 int,
+ *           或为 @ref task (C++20 协程, 需开启 `XF_INIT_ENABLE_CORO`).
+ * @tparam Name 可选的函数名, 需指向具有链接性的 constexpr 字符数组;
+ *              为 nullptr 时在编译期从 F 推导.
+ */
+template <level L, auto F, const char *Name = nullptr>
+struct exporter {
+    static_assert(detail::is_valid_level<L>, "xf::init::exporter: invalid init level");
+    static_assert(std::is_invocable_v<decltype(F)>, "xf::init::exporter: F must be callable without arguments");
+    static_assert(std::is_convertible_v<std::invoke_result_t<decltype(F)>, int> || detail::is_coro<F>(),
+                  "xf::init::exporter: F must return a value convertible to int or xf::init::task");
+
+    constexpr exporter() noexcept
+    {
+        (void)detail::slot<L, F, Name>::anchor();
+    }
+};
+
+} /* namespace init */
+} /* namespace xf */
+
+#endif /* __XF_INIT_HPP__ */
@@ -44,6 +44,349 @@ extern "C" {
 #define XF_INIT_USER_REGISTRY_PATH      "xf_init_registry.inc"
 #endif
 
+#if !defined(XF_INIT_REGISTRY_STATIC_TABLE)
+/**
+ * @brief 注册表模式下是否在编译期直接生成各等级的描述符表。
+ * 开启后注册表需使用 `XF_INIT_REGISTER_<LEVEL>(function)` 形式（末尾不加分号），
+ * 不再有注册函数与链表，初始化时直接遍历常量表。
+ * 默认关闭，兼容旧的 `XF_INIT_REGISTER(function);` 形式。
+ */
+#define XF_INIT_REGISTRY_STATIC_TABLE   0
+#endif
+
+#if !defined(XF_INIT_ENABLE_STATS)
+/**
+ * @brief 是否记录每个初始化 / 挂起 / 恢复函数的耗时与返回值。
+ * 结果通过 `xf_init_stats_*` 接口查询。
+ */
+#define XF_INIT_ENABLE_STATS            0
+#endif
+
+#if !defined(XF_INIT_STATS_MAX_ENTRIES)
+/**
+ * @brief 统计记录的最大条数（静态分配），超出后不再记录。
+ */
+#define XF_INIT_STATS_MAX_ENTRIES       64
+#endif
+
+#if !defined(XF_INIT_ENABLE_PERF_COUNTERS)
+/**
+ * @brief 是否在每个函数前后采样硬件 / 软件性能计数器（仅 Linux，依赖 `XF_INIT_ENABLE_STATS`）。
+ * 使用 perf_event_open，没有权限或内核不支持的计数器会被跳过。
+ */
+#define XF_INIT_ENABLE_PERF_COUNTERS    0
+#endif
+
+#if XF_INIT_ENABLE_PERF_COUNTERS && !XF_INIT_ENABLE_STATS
+#error "XF_INIT_ENABLE_PERF_COUNTERS requires XF_INIT_ENABLE_STATS"
+#endif
+
+/*
+ * XF_INIT_GET_TIME_US(): 获取微秒时间戳（uint64_t），用于统计耗时。
+ * 未定义时在 POSIX 平台上使用 clock_gettime(CLOCK_MONOTONIC)，其他平台需自行定义。
+ */
+
+#if !defined(XF_INIT_ENABLE_PARALLEL_RESUME)
+/**
+ * @brief 恢复时是否并发执行同一等级内的恢复函数（需要 pthread）。
+ * 同一等级内的函数视为相互独立，等级之间仍然按顺序执行。
+ */
+#define XF_INIT_ENABLE_PARALLEL_RESUME  0
+#endif
+
+#if !defined(XF_INIT_ENABLE_PARALLEL_INIT)
+/**
+ * @brief 初始化时是否并发执行同一等级内的初始化函数（需要 pthread）。
+ * 等级之间仍然按顺序执行；共享同一资源的函数用 `XF_INIT_EXPORT_RESOURCE` 声明资源令牌。
+ */
+#define XF_INIT_ENABLE_PARALLEL_INIT    0
+#endif
+
+#if !defined(XF_INIT_PARALLEL_WORKERS)
+/**
+ * @brief 并发执行时的工作线程数（不含调用线程）。
+ */
+#define XF_INIT_PARALLEL_WORKERS        4
+#endif
+
+#if !defined(XF_INIT_PARALLEL_BATCH)
+/**
+ * @brief 单次并发提交的最大函数个数，超出部分分批执行。
+ */
+#define XF_INIT_PARALLEL_BATCH          32
+#endif
+
+#if !defined(XF_INIT_ENABLE_RESOURCE)
+/**
+ * @brief 是否启用资源令牌（`XF_INIT_EXPORT_RESOURCE`），并发执行时错开使用同一资源的函数。
+ */
+#define XF_INIT_ENABLE_RESOURCE         0
+#endif
+
+#if !defined(XF_INIT_RESOURCE_MAX)
+/**
+ * @brief 资源令牌的最大个数。
+ */
+#define XF_INIT_RESOURCE_MAX            16
+#endif
+
+#if !defined(XF_INIT_RESOURCE_DEFAULT_CAPACITY)
+/**
+ * @brief 资源令牌的默认容量，1 表示同一时间只有一个函数使用该资源。
+ */
+#define XF_INIT_RESOURCE_DEFAULT_CAPACITY 1
+#endif
+
+#if !defined(XF_INIT_RESOURCE_NAME_SIZE)
+/**
+ * @brief 资源令牌名的最大长度（含结尾的 '\0'），不超过 256。
+ */
+#define XF_INIT_RESOURCE_NAME_SIZE      32
+#endif
+
+#if !defined(XF_INIT_ENABLE_ZYGOTE)
+/**
+ * @brief 是否启用 zygote（仅 POSIX）。
+ * 父进程预先执行低等级的初始化并常驻, 每个请求 fork 出一个子进程, 子进程只需完成剩余等级。
+ */
+#define XF_INIT_ENABLE_ZYGOTE           0
+#endif
+
+#if !defined(XF_INIT_ENABLE_PROFILE)
+/**
+ * @brief 是否启用启动 profile：按函数名与等级的规则在运行时跳过部分初始化函数。
+ * 规则在第一次初始化前求值一次，结果存为位图。
+ */
+#define XF_INIT_ENABLE_PROFILE          0
+#endif
+
+#if !defined(XF_INIT_PROFILE_MAX_ENTRIES)
+/**
+ * @brief profile 位图覆盖的最大初始化函数个数，超出部分总是执行。
+ */
+#define XF_INIT_PROFILE_MAX_ENTRIES     256
+#endif
+
+#if !defined(XF_INIT_PROFILE_TEXT_SIZE)
+/**
+ * @brief 从文件加载 profile 时的缓冲区大小。
+ */
+#define XF_INIT_PROFILE_TEXT_SIZE       1024
+#endif
+
+#if !defined(XF_INIT_PROFILE_ENV)
+/**
+ * @brief POSIX 平台上读取 profile 的环境变量名。
+ */
+#define XF_INIT_PROFILE_ENV             "XF_INIT_PROFILE"
+#endif
+
+/*
+ * XF_INIT_PROFILE_DEFAULT: 编译期内置的 profile 字符串，未通过接口或环境变量指定时使用。
+ */
+
+#if !defined(XF_INIT_ENABLE_HOST_ONCE)
+/**
+ * @brief 是否启用跨进程只执行一次的初始化函数（仅 Linux，基于共享内存与 OFD 记录锁）。
+ */
+#define XF_INIT_ENABLE_HOST_ONCE        0
+#endif
+
+#if !defined(XF_INIT_HOST_ONCE_SHM_NAME)
+/**
+ * @brief 记录完成状态的共享内存名称，同名的进程之间互相协调。
+ */
+#define XF_INIT_HOST_ONCE_SHM_NAME      "/xf_init_once"
+#endif
+
+#if !defined(XF_INIT_HOST_ONCE_SLOTS)
+/**
+ * @brief 共享内存中可记录的函数个数。
+ */
+#define XF_INIT_HOST_ONCE_SLOTS         64
+#endif
+
+#if !defined(XF_INIT_ENABLE_RETRY)
+/**
+ * @brief 是否启用 `XF_INIT_EXPORT_RETRY`，失败的初始化函数按指数退避异步重试。
+ */
+#define XF_INIT_ENABLE_RETRY            0
+#endif
+
+#if !defined(XF_INIT_RETRY_MAX_BACKOFF_MS)
+/**
+ * @brief 两次重试之间的最大间隔（毫秒）。
+ */
+#define XF_INIT_RETRY_MAX_BACKOFF_MS    10000
+#endif
+
+#if !defined(XF_INIT_RETRY_USE_THREAD)
+/**
+ * @brief 是否由后台线程执行重试（pthread），为 0 时需要在主循环中调用 `xf_init_retry_poll()`。
+ * POSIX 平台默认开启。
+ */
+#   if defined(__unix__) || defined(__APPLE__)
+#       define XF_INIT_RETRY_USE_THREAD 1
+#   else
+#       define XF_INIT_RETRY_USE_THREAD 0
+#   endif
+#endif
+
+#if !defined(XF_INIT_ENABLE_CORO)
+/**
+ * @brief 是否启用 C++20 协程初始化函数（`xf::init::task`）及其事件循环。
+ */
+#define XF_INIT_ENABLE_CORO             0
+#endif
+
+#if !defined(XF_INIT_CORO_MAX_EVENTS)
+/**
+ * @brief 事件循环一次最多处理的 fd 事件个数。
+ */
+#define XF_INIT_CORO_MAX_EVENTS         64
+#endif
+
+#if !defined(XF_INIT_ENABLE_WARMUP)
+/**
+ * @brief 是否启用 `XF_INIT_EXPORT_WARMUP`，所有等级执行完后在后台执行预热函数。
+ */
+#define XF_INIT_ENABLE_WARMUP           0
+#endif
+
+#if !defined(XF_INIT_WARMUP_BUDGET_MS)
+/**
+ * @brief 预热的时间预算（毫秒），超出后不再执行剩余的预热函数。0 表示不限制。
+ */
+#define XF_INIT_WARMUP_BUDGET_MS        0
+#endif
+
+#if !defined(XF_INIT_WARMUP_USE_THREAD)
+/**
+ * @brief 是否由后台线程执行预热（pthread），为 0 时需要在空闲时调用 `xf_init_warmup_run()`。
+ * POSIX 平台默认开启。
+ */
+#   if defined(__unix__) || defined(__APPLE__)
+#       define XF_INIT_WARMUP_USE_THREAD 1
+#   else
+#       define XF_INIT_WARMUP_USE_THREAD 0
+#   endif
+#endif
+
+#if !defined(XF_INIT_WARMUP_AUTO_START)
+/**
+ * @brief 所有等级执行完后是否自动调用 `xf_init_warmup_start()`。
+ */
+#define XF_INIT_WARMUP_AUTO_START       1
+#endif
+
+#if !defined(XF_INIT_ENABLE_PER_CPU)
+/**
+ * @brief 是否启用 `XF_INIT_EXPORT_PER_CPU` / `XF_INIT_EXPORT_PER_THREAD`，
+ * 在每个 CPU 上绑核并发执行（仅 Linux），或在每个线程上执行。
+ */
+#define XF_INIT_ENABLE_PER_CPU          0
+#endif
+
+#if !defined(XF_INIT_PER_CPU_MAX)
+/**
+ * @brief 支持的最大 CPU 编号（不含），决定完成位图的大小。
+ */
+#define XF_INIT_PER_CPU_MAX             256
+#endif
+
+#if !defined(XF_INIT_ENABLE_ARRAY)
+/**
+ * @brief 是否启用 `XF_INIT_EXPORT_ARRAY` / `XF_INIT_EXPORT_ARRAY_EX`，一次导出同类实例数组的初始化。
+ */
+#define XF_INIT_ENABLE_ARRAY            0
+#endif
+
+#if !defined(XF_INIT_ARRAY_THREADS)
+/**
+ * @brief 分段并发执行数组初始化时最多使用的线程数（含调用线程），不超过在线 CPU 数。
+ */
+#define XF_INIT_ARRAY_THREADS           8
+#endif
+
+#if !defined(XF_INIT_ENABLE_ARENA)
+/**
+ * @brief 是否启用初始化期间使用的 bump 分配器 `xf_init_alloc()`。
+ */
+#define XF_INIT_ENABLE_ARENA            0
+#endif
+
+#if !defined(XF_INIT_ARENA_SIZE)
+/**
+ * @brief 可写 arena 的大小。POSIX 上只占用虚拟地址空间，非 POSIX 平台为静态数组，需按实际用量调小。
+ */
+#define XF_INIT_ARENA_SIZE              (4u * 1024u * 1024u)
+#endif
+
+#if !defined(XF_INIT_ARENA_RO_SIZE)
+/**
+ * @brief 只读 arena（`xf_init_alloc_ro()`）的大小。
+ */
+#define XF_INIT_ARENA_RO_SIZE           (1u * 1024u * 1024u)
+#endif
+
+#if !defined(XF_INIT_ARENA_CHUNK_SIZE)
+/**
+ * @brief 每个线程一次从 arena 中取走的块大小。
+ */
+#define XF_INIT_ARENA_CHUNK_SIZE        (64u * 1024u)
+#endif
+
+#if !defined(XF_INIT_ARENA_ALIGN)
+/**
+ * @brief 默认对齐。
+ */
+#define XF_INIT_ARENA_ALIGN             16
+#endif
+
+#if !defined(XF_INIT_ARENA_HUGE_PAGES)
+/**
+ * @brief 是否建议内核对 arena 使用透明大页（Linux, madvise(MADV_HUGEPAGE)）。
+ */
+#define XF_INIT_ARENA_HUGE_PAGES        1
+#endif
+
+#if !defined(XF_INIT_ARENA_SEAL_AFTER_INIT)
+/**
+ * @brief 所有等级执行完后是否自动把只读 arena 设为只读（`xf_init_arena_seal()`）。
+ */
+#define XF_INIT_ARENA_SEAL_AFTER_INIT   0
+#endif
+
+#if !defined(XF_INIT_ENABLE_RELEASE)
+/**
+ * @brief 是否启用 `__xf_init` / `__xf_initdata` / `__xf_initconst` 标记与 `xf_init_release()`。
+ * 标记的代码与数据放入独立的段（需使用 linker 目录下的链接脚本），初始化完成后回收。
+ */
+#define XF_INIT_ENABLE_RELEASE          0
+#endif
+
+#if !defined(XF_INIT_RELEASE_UNMAP)
+/**
+ * @brief POSIX 平台上回收时直接 munmap（之后误访问会立即段错误），
+ * 为 0 时使用 madvise(MADV_DONTNEED) 只释放物理页。
+ */
+#define XF_INIT_RELEASE_UNMAP           0
+#endif
+
+/*
+ * XF_INIT_RELEASE_TO_HEAP(addr, size): 非 POSIX 平台（MCU）上把回收的数据区交给堆的接口，
+ * 如 `#define XF_INIT_RELEASE_TO_HEAP(addr, size) heap_add_region(addr, size)`，未定义时不回收。
+ */
+
+/**
+ * @brief 是否需要编译并发执行的线程池。
+ */
+#define XF_INIT_USE_PARALLEL            (XF_INIT_ENABLE_PARALLEL_RESUME || XF_INIT_ENABLE_PARALLEL_INIT)
+
+#if XF_INIT_ENABLE_PARALLEL_INIT && XF_INIT_ENABLE_CORO
+#error "XF_INIT_ENABLE_PARALLEL_INIT cannot be used with XF_INIT_ENABLE_CORO (the event loop is single-threaded)"
+#endif
+
 // 如果你设置的模式不是这三个，则会报错
 #if XF_INIT_IMPL_METHOD != XF_INIT_IMPL_BY_SECTION && XF_INIT_IMPL_METHOD != XF_INIT_IMPL_BY_CONSTRUCTOR && XF_INIT_IMPL_METHOD != XF_INIT_IMPL_BY_REGISTRY
 #error "XF_INIT_IMPL_METHOD must be one of: XF_INIT_IMPL_BY_SECTION, XF_INIT_IMPL_BY_CONSTRUCTOR, XF_INIT_IMPL_BY_REGISTRY"
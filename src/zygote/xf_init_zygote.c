@@ -0,0 +1,322 @@
+/**
+ * @file xf_init_zygote.c
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 预初始化的 fork 服务 (zygote)。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init.h"
+
+#if XF_INIT_ENABLE_ZYGOTE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "zygote"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int xf_init_zygote_addr(const char *path, struct sockaddr_un *p_addr);
+static void xf_init_zygote_reap(void);
+static void xf_init_zygote_on_sigchld(int sig);
+static int xf_init_zygote_watch_children(void);
+static void xf_init_zygote_unwatch_children(void);
+static int xf_init_zygote_write_all(int fd, const void *buf, size_t size);
+static int xf_init_zygote_read_all(int fd, void *buf, size_t size);
+
+/* ==================== [Static Variables] ================================== */
+
+/* 父进程执行到的等级, 0 表示尚未 prepare */
+static uint8_t s_last_level = 0;
+
+/* SIGCHLD 自管道: 信号处理函数写入, 服务循环与监听 fd 一起 poll, 空闲时也能及时回收子进程 */
+static int s_chld_pipe[2] = { -1, -1 };
+static struct sigaction s_chld_old_action;
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_init_zygote_prepare(uint8_t last_level)
+{
+    xf_err_t err;
+
+    if (s_last_level != 0) {
+        return XF_ERR_INITED;
+    }
+
+    err = xf_init_levels(XF_INIT_LEVEL_SETUP, last_level);
+    if (err != XF_OK) {
+        return err;
+    }
+    s_last_level = last_level;
+
+    XF_LOGD(TAG, "zygote prepared up to level %u.", (unsigned)last_level);
+    return XF_OK;
+}
+
+int xf_init_zygote_fork(void)
+{
+    pid_t pid;
+
+    if (s_last_level == 0) {
+        return -1;
+    }
+
+    /* 避免子进程重复输出父进程缓冲区中的内容 */
+    fflush(NULL);
+    pid = fork();
+    if (pid != 0) {
+        return (int)pid;
+    }
+
+    /* 子进程的 SIGCHLD 属于它自己 */
+    if (s_chld_pipe[0] >= 0) {
+        xf_init_zygote_unwatch_children();
+    }
+    xf_init_postfork();
+    if (s_last_level < XF_INIT_LEVEL_APP) {
+        xf_init_levels((uint8_t)(s_last_level + 1), XF_INIT_LEVEL_APP);
+    }
+    return 0;
+}
+
+xf_err_t xf_init_zygote_serve(const char *path, xf_init_zygote_main_t child_main, void *user_data)
+{
+    struct sockaddr_un addr;
+    int listen_fd;
+
+    if ((NULL == path) || (NULL == child_main)) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (s_last_level == 0) {
+        return XF_ERR_UNINIT;
+    }
+    if (xf_init_zygote_addr(path, &addr) != 0) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        return XF_FAIL;
+    }
+    unlink(path);
+    if ((bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+            || (listen(listen_fd, SOMAXCONN) != 0)) {
+        XF_LOGE(TAG, "listen on %s failed: %s", path, strerror(errno));
+        close(listen_fd);
+        return XF_FAIL;
+    }
+    if (xf_init_zygote_watch_children() != 0) {
+        XF_LOGE(TAG, "watch children failed: %s", strerror(errno));
+        close(listen_fd);
+        return XF_FAIL;
+    }
+
+    XF_LOGI(TAG, "zygote listening on %s.", path);
+    for (;;) {
+        struct pollfd fds[2] = {
+            { .fd = listen_fd,      .events = POLLIN },
+            { .fd = s_chld_pipe[0], .events = POLLIN },
+        };
+        int conn_fd;
+
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            XF_LOGE(TAG, "poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            char buf[64];
+            while (read(s_chld_pipe[0], buf, sizeof(buf)) > 0) {
+            }
+            xf_init_zygote_reap();
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        conn_fd = accept(listen_fd, NULL, NULL);
+        if (conn_fd < 0) {
+            if ((errno == EINTR) || (errno == EAGAIN) || (errno == ECONNABORTED)) {
+                continue;
+            }
+            XF_LOGE(TAG, "accept failed: %s", strerror(errno));
+            break;
+        }
+
+        int pid = xf_init_zygote_fork();
+        if (pid == 0) {
+            int32_t self = (int32_t)getpid();
+            int ret = 1;
+            close(listen_fd);
+            if (xf_init_zygote_write_all(conn_fd, &self, sizeof(self)) == 0) {
+                ret = child_main(conn_fd, user_data);
+            }
+            close(conn_fd);
+            fflush(NULL);
+            /* 不执行父进程注册的 atexit, 它们属于父进程 */
+            _exit(ret);
+        }
+        if (pid < 0) {
+            XF_LOGE(TAG, "fork failed: %s", strerror(errno));
+        }
+        close(conn_fd);
+    }
+
+    xf_init_zygote_unwatch_children();
+    close(listen_fd);
+    return XF_FAIL;
+}
+
+int xf_init_zygote_spawn(const char *path, int *p_pid)
+{
+    struct sockaddr_un addr;
+    int32_t pid = 0;
+    int fd;
+
+    if ((NULL == path) || (xf_init_zygote_addr(path, &addr) != 0)) {
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+            || (xf_init_zygote_read_all(fd, &pid, sizeof(pid)) != 0)) {
+        close(fd);
+        return -1;
+    }
+    if (p_pid) {
+        *p_pid = (int)pid;
+    }
+    return fd;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int xf_init_zygote_addr(const char *path, struct sockaddr_un *p_addr)
+{
+    size_t len = strlen(path);
+    if (len >= sizeof(p_addr->sun_path)) {
+        return -1;
+    }
+    memset(p_addr, 0, sizeof(*p_addr));
+    p_addr->sun_family = AF_UNIX;
+    memcpy(p_addr->sun_path, path, len + 1);
+    return 0;
+}
+
+static void xf_init_zygote_reap(void)
+{
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+}
+
+static void xf_init_zygote_on_sigchld(int sig)
+{
+    int saved_errno = errno;
+    char c = 0;
+    UNUSED(sig);
+    /* 管道满时说明已有未处理的通知, 丢弃即可 */
+    if (write(s_chld_pipe[1], &c, 1) < 0) {
+    }
+    errno = saved_errno;
+}
+
+static int xf_init_zygote_watch_children(void)
+{
+    struct sigaction action;
+    int i;
+
+    if (pipe(s_chld_pipe) != 0) {
+        return -1;
+    }
+    for (i = 0; i < 2; i++) {
+        fcntl(s_chld_pipe[i], F_SETFL, fcntl(s_chld_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(s_chld_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = xf_init_zygote_on_sigchld;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    if (sigaction(SIGCHLD, &action, &s_chld_old_action) != 0) {
+        close(s_chld_pipe[0]);
+        close(s_chld_pipe[1]);
+        s_chld_pipe[0] = s_chld_pipe[1] = -1;
+        return -1;
+    }
+    /* 安装前已经退出的子进程 */
+    xf_init_zygote_reap();
+    return 0;
+}
+
+static void xf_init_zygote_unwatch_children(void)
+{
+    int i;
+
+    sigaction(SIGCHLD, &s_chld_old_action, NULL);
+    for (i = 0; i < 2; i++) {
+        if (s_chld_pipe[i] >= 0) {
+            close(s_chld_pipe[i]);
+            s_chld_pipe[i] = -1;
+        }
+    }
+}
+
+static int xf_init_zygote_write_all(int fd, const void *buf, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static int xf_init_zygote_read_all(int fd, void *buf, size_t size)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+#endif /* XF_INIT_ENABLE_ZYGOTE */
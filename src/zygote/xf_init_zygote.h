@@ -0,0 +1,114 @@
+/**
+ * @file xf_init_zygote.h
+ * @author cangyu (sky.kirto@qq.com)
+ * @brief 预初始化的 fork 服务 (zygote)。
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024, CorAL. All rights reserved.
+ *
+ */
+
+#ifndef __XF_INIT_ZYGOTE_H__
+#define __XF_INIT_ZYGOTE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "../xf_init_config_internal.h"
+#include "../dispatch/xf_init_dispatch.h"
+#include "xf_utils.h"
+
+#if XF_INIT_ENABLE_ZYGOTE || defined(__DOXYGEN__)
+
+/**
+ * @cond XFAPI_USER
+ * @ingroup group_xf_init
+ * @defgroup group_xf_init_zygote zygote
+ * @brief 父进程只初始化一次, 之后按需 fork 出已初始化的子进程。需要开启 `XF_INIT_ENABLE_ZYGOTE`.
+ *
+ * 父进程执行 SETUP ~ last_level 后常驻, 子进程以写时复制的方式继承这些状态,
+ * 先调用 fork 后的重新初始化函数 (见 @ref XF_INIT_EXPORT_POSTFORK), 再执行剩余等级.
+ * @endcond
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 子进程入口.
+ *
+ * @param fd 与请求方的连接, 返回后自动关闭.
+ * @param user_data 用户数据.
+ * @return int 子进程的退出码.
+ */
+typedef int (*xf_init_zygote_main_t)(int fd, void *user_data);
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 在父进程中执行 SETUP ~ last_level 的初始化函数.
+ *
+ * 只能调用一次, 调用后不要再调用 @ref xf_init.
+ *
+ * @param last_level 父进程执行到的等级 (包含), 见 XF_INIT_LEVEL_*.
+ * @return xf_err_t
+ *      - XF_ERR_INITED             已经调用过
+ *      - XF_ERR_INVALID_ARG        等级无效
+ *      - XF_OK                     成功
+ */
+xf_err_t xf_init_zygote_prepare(uint8_t last_level);
+
+/**
+ * @brief fork 出一个子进程, 子进程中完成 fork 后的重新初始化及剩余等级的初始化.
+ *
+ * @return int
+ *      - -1                        失败 (未 prepare 或 fork 失败)
+ *      - 0                         在子进程中返回
+ *      - > 0                       在父进程中返回, 为子进程 pid
+ */
+int xf_init_zygote_fork(void);
+
+/**
+ * @brief 在本地 (AF_UNIX) 套接字上等待请求, 每个连接 fork 一个子进程.
+ *
+ * 子进程先向连接写入自身 pid (int32_t), 然后调用 child_main, 返回后退出;
+ * 父进程关闭自己持有的连接. 服务期间接管 SIGCHLD, 子进程一退出即回收 (空闲时也不会留下僵尸进程),
+ * 返回前恢复原来的处理方式. 正常情况下不会返回.
+ *
+ * @param path 套接字路径, 已存在时会先删除.
+ * @param child_main 子进程入口.
+ * @param user_data 传给 child_main 的用户数据.
+ * @return xf_err_t
+ *      - XF_ERR_UNINIT             未调用 @ref xf_init_zygote_prepare
+ *      - XF_ERR_INVALID_ARG        参数无效
+ *      - XF_FAIL                   套接字出错
+ */
+xf_err_t xf_init_zygote_serve(const char *path, xf_init_zygote_main_t child_main, void *user_data);
+
+/**
+ * @brief 请求方使用: 向 zygote 请求一个子进程.
+ *
+ * @param path zygote 的套接字路径.
+ * @param[out] p_pid 子进程 pid, 可为 NULL.
+ * @return int 与子进程的连接, 失败时为 -1.
+ */
+int xf_init_zygote_spawn(const char *path, int *p_pid);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/**
+ * End of defgroup group_xf_init_zygote
+ * @}
+ */
+
+#endif /* XF_INIT_ENABLE_ZYGOTE */
+
+#endif /* __XF_INIT_ZYGOTE_H__ */
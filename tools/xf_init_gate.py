@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+@file xf_init_gate.py
+@brief 启动耗时回归门禁: 多次运行启动, 与保存的基线做统计检验, 给出机器可读的结论与退出码.
+
+每次启动的耗时记录为 xf_init_stats_export() 输出的 CSV (使用 init 与 warmup 阶段). 每个初始化函数取各次运行的
+time_us 作为样本; 每个等级取该等级第一个函数开始到最后一个函数结束的时间 (并发执行时也成立);
+另外统计整个启动的耗时 (`<boot>`). 预热函数在启动之后于后台执行, 不计入启动耗时, 单独记为
+`warmup:<name>` 与整个预热阶段的耗时 (`<warmup>`).
+
+判定为回归需同时满足:
+  - 单侧 Mann-Whitney U 检验 p < --alpha (当前运行比基线慢);
+  - 中位数增加超过 --threshold 百分比;
+  - 中位数增加超过 --min-us 微秒 (忽略很短的函数的抖动).
+
+样本来源:
+  - --cmd: 运行 N 次 (--runs) 命令. 命令中的 `{csv}` 替换为临时文件路径, 由程序写入 CSV;
+    不含 `{csv}` 时从标准输出中读取 CSV (表头之前及非 CSV 行 (如日志) 被忽略);
+  - 直接给出 CSV 文件, 每个文件为一次运行; 一个文件中出现多个表头时每个表头开始一次运行.
+
+用法:
+  xf_init_gate.py record -o baseline.json --runs 20 --cmd "build/app --boot-only --stats {csv}"
+  xf_init_gate.py compare baseline.json --runs 20 --cmd "..." [--threshold 10] [--json verdict.json]
+  xf_init_gate.py compare baseline.json run1.csv run2.csv ...
+
+退出码: 0 通过, 1 存在回归, 2 参数或运行错误.
+
+只依赖 Python 3 标准库.
+"""
+
+import argparse
+import csv
+import io
+import json
+import math
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+
+LEVEL_NAMES = {
+    1: "SETUP",
+    2: "BOARD",
+    3: "PREV",
+    4: "CLEANUP",
+    5: "DEVICE",
+    6: "COMPONENT",
+    7: "ENV",
+    8: "APP",
+}
+
+STAGES = ("init", "suspend", "resume", "postfork", "warmup")
+HEADER_PREFIX = "stage,level,name,"
+BOOT_KEY = "<boot>"
+WARMUP_KEY = "<warmup>"
+WARMUP_PREFIX = "warmup:"
+
+FORMAT_VERSION = 1
+
+EXIT_PASS = 0
+EXIT_REGRESSION = 1
+EXIT_ERROR = 2
+
+
+class GateError(Exception):
+    pass
+
+
+def split_runs(text):
+    """把一段输出按表头切分为多次运行, 每次运行为 CSV 行的列表."""
+    runs = []
+    current = None
+    for line in text.splitlines():
+        line = line.strip()
+        if line.startswith(HEADER_PREFIX):
+            current = [line]
+            runs.append(current)
+        elif current is not None and line.split(",", 1)[0] in STAGES:
+            current.append(line)
+    return [r for r in runs if len(r) > 1]
+
+
+def parse_run(lines):
+    """返回 {name: time_us}, {level: wall_us} 与整个启动的耗时; 预热函数以 `warmup:<name>` 计入前者."""
+    entries = {}
+    spans = {}
+    warmup = None
+    for row in csv.DictReader(io.StringIO("\n".join(lines))):
+        start = int(row["start_us"])
+        time_us = int(row["time_us"])
+        if row["stage"] == "warmup":
+            name = WARMUP_PREFIX + row["name"]
+            entries[name] = entries.get(name, 0) + time_us
+            first, last = warmup or (start, start + time_us)
+            warmup = (min(first, start), max(last, start + time_us))
+            continue
+        if row["stage"] != "init":
+            continue
+        level = int(row["level"])
+        # 同名函数在一次运行中出现多次时累加 (如多次调用 xf_init_level)
+        entries[row["name"]] = entries.get(row["name"], 0) + time_us
+        first, last = spans.get(level, (start, start + time_us))
+        spans[level] = (min(first, start), max(last, start + time_us))
+    levels = {level: last - first for level, (first, last) in spans.items()}
+    boot = 0
+    if spans:
+        boot = max(last for _, last in spans.values()) - min(first for first, _ in spans.values())
+    if warmup:
+        entries[WARMUP_KEY] = warmup[1] - warmup[0]
+    return entries, levels, boot
+
+
+def collect(runs_lines):
+    """把多次运行合并为 {key: [samples]}. key 为函数名、`level:<NAME>`、`<boot>`、`warmup:<name>` 或 `<warmup>`."""
+    samples = {}
+    for lines in runs_lines:
+        entries, levels, boot = parse_run(lines)
+        for name, t in entries.items():
+            samples.setdefault(name, []).append(t)
+        for level, t in levels.items():
+            samples.setdefault("level:%s" % LEVEL_NAMES.get(level, level), []).append(t)
+        samples.setdefault(BOOT_KEY, []).append(boot)
+    return samples
+
+
+def run_command(cmd, runs, timeout):
+    collected = []
+    for i in range(runs):
+        path = None
+        argv = cmd
+        if "{csv}" in cmd:
+            fd, path = tempfile.mkstemp(prefix="xf_init_gate_", suffix=".csv")
+            os.close(fd)
+            argv = cmd.replace("{csv}", shlex.quote(path))
+        try:
+            proc = subprocess.run(argv, shell=True, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                                  universal_newlines=True, timeout=timeout)
+            if proc.returncode != 0:
+                raise GateError("run %d: command exited with %d" % (i + 1, proc.returncode))
+            if path:
+                with open(path, newline="") as f:
+                    text = f.read()
+            else:
+                text = proc.stdout
+        except subprocess.TimeoutExpired:
+            raise GateError("run %d: command timed out after %ss" % (i + 1, timeout))
+        finally:
+            if path:
+                os.unlink(path)
+        found = split_runs(text)
+        if not found:
+            raise GateError("run %d: no xf_init_stats_export() CSV in output" % (i + 1))
+        collected.append(found[-1])
+    return collected
+
+
+def load_runs(args):
+    runs = []
+    if args.cmd:
+        runs += run_command(args.cmd, args.runs, args.timeout)
+    for path in args.csv:
+        with open(path, newline="") as f:
+            found = split_runs(f.read())
+        if not found:
+            raise GateError("%s: no xf_init_stats_export() CSV found" % path)
+        runs += found
+    if not runs:
+        raise GateError("no runs: give --cmd or CSV files")
+    return runs
+
+
+def median(xs):
+    s = sorted(xs)
+    n = len(s)
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2.0
+
+
+def percentile(xs, p):
+    s = sorted(xs)
+    k = (len(s) - 1) * p / 100.0
+    lo = int(math.floor(k))
+    hi = min(lo + 1, len(s) - 1)
+    return s[lo] + (s[hi] - s[lo]) * (k - lo)
+
+
+def mann_whitney_greater(base, cur):
+    """单侧 Mann-Whitney U 检验 (正态近似, 带并列修正), 返回 cur 大于 base 的 p 值."""
+    n1 = len(base)
+    n2 = len(cur)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    pooled = sorted([(v, 0) for v in base] + [(v, 1) for v in cur])
+    ranks = [0.0] * len(pooled)
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r2 = sum(r for r, (_, g) in zip(ranks, pooled) if g == 1)
+    u2 = r2 - n2 * (n2 + 1) / 2.0
+    n = n1 + n2
+    mu = n1 * n2 / 2.0
+    var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1))) if n > 1 else 0.0
+    if var <= 0:
+        return 1.0
+    z = (u2 - mu - 0.5) / math.sqrt(var)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def summarize(xs):
+    return {
+        "n": len(xs),
+        "median": median(xs),
+        "p90": percentile(xs, 90),
+        "min": min(xs),
+        "max": max(xs),
+    }
+
+
+def compare(baseline, current, args):
+    results = []
+    for key in sorted(set(baseline) | set(current)):
+        base = baseline.get(key)
+        cur = current.get(key)
+        item = {"name": key}
+        if not base:
+            item["status"] = "new"
+        elif not cur:
+            item["status"] = "missing"
+        else:
+            bm = median(base)
+            cm = median(cur)
+            delta = cm - bm
+            pct = (delta * 100.0 / bm) if bm > 0 else (0.0 if delta <= 0 else float("inf"))
+            p = mann_whitney_greater(base, cur)
+            regressed = p < args.alpha and pct > args.threshold and delta > args.min_us
+            item.update({
+                "status": "regressed" if regressed else "ok",
+                "baseline": summarize(base),
+                "current": summarize(cur),
+                "delta_us": delta,
+                "delta_pct": pct if math.isfinite(pct) else None,
+                "p_value": p,
+            })
+        results.append(item)
+    return results
+
+
+def cmd_record(args):
+    samples = collect(load_runs(args))
+    out = {
+        "version": FORMAT_VERSION,
+        "runs": len(samples.get(BOOT_KEY, [])),
+        "samples": samples,
+    }
+    with open(args.output, "w") as f:
+        json.dump(out, f, indent=1, sort_keys=True)
+    print("recorded %d runs, %d keys -> %s" % (out["runs"], len(samples), args.output))
+    return EXIT_PASS
+
+
+def cmd_compare(args):
+    with open(args.baseline) as f:
+        data = json.load(f)
+    if data.get("version") != FORMAT_VERSION:
+        raise GateError("%s: unsupported baseline version %r" % (args.baseline, data.get("version")))
+    baseline = data["samples"]
+    current = collect(load_runs(args))
+    results = compare(baseline, current, args)
+    regressed = [r for r in results if r["status"] == "regressed"]
+
+    verdict = {
+        "verdict": "fail" if regressed else "pass",
+        "baseline_runs": data.get("runs", 0),
+        "current_runs": len(current.get(BOOT_KEY, [])),
+        "threshold_pct": args.threshold,
+        "alpha": args.alpha,
+        "min_us": args.min_us,
+        "regressed": [r["name"] for r in regressed],
+        "results": results,
+    }
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(verdict, f, indent=1)
+
+    print("%-40s %12s %12s %9s %9s  %s" % ("name", "base_us", "cur_us", "delta", "p", "status"))
+    for r in results:
+        if "baseline" not in r:
+            print("%-40s %12s %12s %9s %9s  %s" % (r["name"], "-", "-", "-", "-", r["status"]))
+            continue
+        pct = "%+.1f%%" % r["delta_pct"] if r["delta_pct"] is not None else "new>0"
+        print("%-40s %12.0f %12.0f %9s %9.4f  %s" % (r["name"], r["baseline"]["median"],
+                                                     r["current"]["median"], pct, r["p_value"], r["status"]))
+    print()
+    print("verdict: %s (%d regressed)" % (verdict["verdict"].upper(), len(regressed)))
+    return EXIT_REGRESSION if regressed else EXIT_PASS
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="xf_init boot-time regression gate")
+    sub = parser.add_subparsers(dest="command")
+
+    def add_source(p):
+        p.add_argument("csv", nargs="*", help="CSV files from xf_init_stats_export(), one run each")
+        p.add_argument("--cmd", help="boot command to run, '{csv}' is replaced by the output path")
+        p.add_argument("--runs", type=int, default=10, help="number of runs of --cmd (default: 10)")
+        p.add_argument("--timeout", type=float, default=60, help="timeout of one run in seconds (default: 60)")
+
+    p = sub.add_parser("record", help="record a baseline")
+    p.add_argument("-o", "--output", required=True, help="baseline JSON to write")
+    add_source(p)
+
+    p = sub.add_parser("compare", help="compare against a baseline")
+    p.add_argument("baseline", help="baseline JSON from 'record'")
+    add_source(p)
+    p.add_argument("--threshold", type=float, default=10.0, help="median increase in percent (default: 10)")
+    p.add_argument("--alpha", type=float, default=0.01, help="significance level (default: 0.01)")
+    p.add_argument("--min-us", type=float, default=100.0, help="ignore increases below this (default: 100)")
+    p.add_argument("--json", help="write the machine-readable verdict to this file")
+
+    args = parser.parse_args(argv)
+    if args.command is None:
+        parser.print_help()
+        return EXIT_ERROR
+    if args.runs < 1:
+        print("error: --runs must be at least 1", file=sys.stderr)
+        return EXIT_ERROR
+
+    try:
+        return cmd_record(args) if args.command == "record" else cmd_compare(args)
+    except (OSError, ValueError, KeyError, GateError) as e:
+        print("error: %s" % e, file=sys.stderr)
+        return EXIT_ERROR
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,440 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+@file xf_init_plan.py
+@brief 离线分析 ELF 镜像中的初始化计划, 计算关键路径与 N 个工作线程下的启动耗时.
+
+从链接后的镜像中还原初始化计划:
+  - section 模式: 读取 __xf_init_start ~ __xf_init_end 之间的描述符
+    (即 linker/*.ld 中 KEEP(*(SORT(.xf_auto_init*))) 生成的布局);
+  - registry 静态表模式: 读取 s_init_table_<level> 表;
+  - constructor / registry 链表模式: 只能从 __xf_init_desc_<name> 符号得到函数名, 等级取自耗时记录.
+
+耗时记录为 xf_init_stats_export() 输出的 CSV. 依赖文件 (可选) 每行形如 `name: dep1 dep2`,
+依赖只在同一等级内有意义, 跨等级的依赖由等级顺序保证.
+
+用法:
+  xf_init_plan.py build/xf_init --profile boot.csv --workers 4 [--deps deps.txt] [--top 5]
+
+只依赖 Python 3 标准库.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+LEVEL_NAMES = {
+    1: "SETUP",
+    2: "BOARD",
+    3: "PREV",
+    4: "CLEANUP",
+    5: "DEVICE",
+    6: "COMPONENT",
+    7: "ENV",
+    8: "APP",
+}
+LEVEL_FIRST = 1
+LEVEL_LAST = 8
+
+SHT_SYMTAB = 2
+SHT_RELA = 4
+SHT_NOBITS = 8
+SHT_REL = 9
+SHT_DYNSYM = 11
+
+# 链表节点及挂起 / 恢复 / 预热等阶段的描述符不属于初始化计划
+SKIPPED_DESC_PREFIXES = tuple("__xf_init_desc_" + p for p in ("node_", "suspend_", "resume_", "postfork_", "warmup_"))
+
+# 各架构的 R_*_RELATIVE, PIE 镜像中描述符里的指针需要按它还原
+RELATIVE_TYPES = {
+    3: 8,       # EM_386
+    40: 23,     # EM_ARM
+    62: 8,      # EM_X86_64
+    183: 1027,  # EM_AARCH64
+    243: 3,     # EM_RISCV
+}
+
+
+class ElfError(Exception):
+    pass
+
+
+class Elf:
+    """只实现分析所需的最小 ELF 读取: 节、符号、RELATIVE 重定位."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ElfError("%s is not an ELF file" % path)
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        self.ptr_size = 8 if self.is64 else 4
+        self.ptr_fmt = self.endian + ("Q" if self.is64 else "I")
+        self._parse_header()
+        self._parse_sections()
+        self._parse_symbols()
+        self._parse_relocations()
+
+    def _unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def _parse_header(self):
+        if self.is64:
+            (self.machine,) = self._unpack("H", 18)
+            (self.shoff,) = self._unpack("Q", 40)
+            self.shentsize, self.shnum, self.shstrndx = self._unpack("HHH", 58)
+        else:
+            (self.machine,) = self._unpack("H", 18)
+            (self.shoff,) = self._unpack("I", 32)
+            self.shentsize, self.shnum, self.shstrndx = self._unpack("HHH", 46)
+
+    def _parse_sections(self):
+        self.sections = []
+        for i in range(self.shnum):
+            off = self.shoff + i * self.shentsize
+            if self.is64:
+                name, typ, flags, addr, offset, size, link, info, align, entsize = \
+                    self._unpack("IIQQQQIIQQ", off)
+            else:
+                name, typ, flags, addr, offset, size, link, info, align, entsize = \
+                    self._unpack("IIIIIIIIII", off)
+            self.sections.append({
+                "name_off": name, "type": typ, "addr": addr, "offset": offset,
+                "size": size, "link": link, "entsize": entsize,
+            })
+        strtab = self.sections[self.shstrndx]
+        for sec in self.sections:
+            sec["name"] = self._cstr(strtab["offset"] + sec["name_off"])
+
+    def _parse_symbols(self):
+        self.symbols = {}
+        self.addr_to_name = {}
+        for sec in self.sections:
+            if sec["type"] not in (SHT_SYMTAB, SHT_DYNSYM):
+                continue
+            strtab = self.sections[sec["link"]]
+            entsize = sec["entsize"] or (24 if self.is64 else 16)
+            for off in range(sec["offset"], sec["offset"] + sec["size"], entsize):
+                if self.is64:
+                    name, info, other, shndx, value, size = self._unpack("IBBHQQ", off)
+                else:
+                    name, value, size, info, other, shndx = self._unpack("IIIBBH", off)
+                if name == 0 or shndx == 0:
+                    continue
+                sym = self._cstr(strtab["offset"] + name)
+                self.symbols.setdefault(sym, (value, size))
+                if (info & 0xf) == 2:   # STT_FUNC
+                    self.addr_to_name.setdefault(value & ~1, sym)
+
+    def _parse_relocations(self):
+        self.relative = {}
+        rtype = RELATIVE_TYPES.get(self.machine)
+        if rtype is None:
+            return
+        for sec in self.sections:
+            if sec["type"] != SHT_RELA:
+                continue
+            entsize = sec["entsize"] or (24 if self.is64 else 12)
+            for off in range(sec["offset"], sec["offset"] + sec["size"], entsize):
+                if self.is64:
+                    r_offset, r_info, r_addend = self._unpack("QQq", off)
+                    typ = r_info & 0xffffffff
+                else:
+                    r_offset, r_info, r_addend = self._unpack("IIi", off)
+                    typ = r_info & 0xff
+                if typ == rtype:
+                    self.relative[r_offset] = r_addend
+
+    def _cstr(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end].decode("utf-8", "replace")
+
+    def _file_offset(self, addr):
+        for sec in self.sections:
+            if sec["type"] == SHT_NOBITS or sec["addr"] == 0:
+                continue
+            if sec["addr"] <= addr < sec["addr"] + sec["size"]:
+                return sec["offset"] + addr - sec["addr"]
+        raise ElfError("address 0x%x is not in any loaded section" % addr)
+
+    def read_ptr(self, addr):
+        if addr in self.relative:
+            return self.relative[addr]
+        (value,) = struct.unpack_from(self.ptr_fmt, self.data, self._file_offset(addr))
+        return value
+
+    def read_u8(self, addr):
+        return self.data[self._file_offset(addr)]
+
+    def read_str(self, addr):
+        return self._cstr(self._file_offset(addr))
+
+
+class Entry:
+    def __init__(self, name, level, func=None):
+        self.name = name
+        self.level = level
+        self.func = func
+        self.time_us = 0.0
+        self.deps = set()
+
+
+def plan_from_section(elf):
+    """section 模式: 描述符为 {func, func_name, level[, resource]}, 按指针大小对齐."""
+    start = elf.symbols.get("__xf_init_start")
+    end = elf.symbols.get("__xf_init_end")
+    if not start or not end:
+        return None
+    # 开启 XF_INIT_ENABLE_RESOURCE 时描述符多一个指针, 以首描述符的符号大小为准
+    desc_size = start[1]
+    if desc_size < 3 * elf.ptr_size or desc_size % elf.ptr_size:
+        desc_size = 3 * elf.ptr_size
+    entries = []
+    for addr in range(start[0] + desc_size, end[0], desc_size):
+        func = elf.read_ptr(addr)
+        name_ptr = elf.read_ptr(addr + elf.ptr_size)
+        level = elf.read_u8(addr + 2 * elf.ptr_size)
+        if func == 0 or not (LEVEL_FIRST <= level <= LEVEL_LAST):
+            continue
+        entries.append(Entry(elf.read_str(name_ptr), level, func))
+    return entries
+
+
+def plan_from_static_table(elf):
+    """registry 静态表模式: s_init_table_<level> 为以 NULL 结尾的描述符指针表."""
+    entries = []
+    found = False
+    for level, level_name in LEVEL_NAMES.items():
+        sym = elf.symbols.get("s_init_table_" + level_name.lower())
+        if not sym:
+            continue
+        found = True
+        addr = sym[0]
+        while True:
+            p_desc = elf.read_ptr(addr)
+            if p_desc == 0:
+                break
+            func = elf.read_ptr(p_desc)
+            name = elf.read_str(elf.read_ptr(p_desc + elf.ptr_size))
+            entries.append(Entry(name, level, func))
+            addr += elf.ptr_size
+    return entries if found else None
+
+
+def plan_from_constructor(elf):
+    """constructor / registry 链表模式: 等级在运行时才确定, 这里只收集函数名."""
+    entries = []
+    for sym, (value, _) in elf.symbols.items():
+        if not sym.startswith("__xf_init_desc_") or sym.startswith(SKIPPED_DESC_PREFIXES):
+            continue
+        try:
+            name = elf.read_str(elf.read_ptr(value + elf.ptr_size))
+        except (ElfError, ValueError):
+            continue
+        entries.append(Entry(name, 0, elf.read_ptr(value)))
+    return entries or None
+
+
+def load_plan(path):
+    elf = Elf(path)
+    for loader, mode in ((plan_from_section, "section"),
+                         (plan_from_static_table, "registry (static table)"),
+                         (plan_from_constructor, "constructor / registry")):
+        entries = loader(elf)
+        if entries is not None:
+            return mode, entries
+    raise ElfError("no xf_init descriptors found in %s (stripped?)" % path)
+
+
+def load_profile(path):
+    """读取 xf_init_stats_export() 的 CSV, 同名函数多次出现时取平均值."""
+    samples = {}
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            if row.get("stage", "init") != "init":
+                continue
+            key = row["name"]
+            level, total, count = samples.get(key, (int(row["level"]), 0.0, 0))
+            samples[key] = (level, total + float(row["time_us"]), count + 1)
+    return {name: (level, total / count) for name, (level, total, count) in samples.items()}
+
+
+def load_deps(path):
+    deps = {}
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line or ":" not in line:
+                continue
+            name, rest = line.split(":", 1)
+            deps.setdefault(name.strip(), set()).update(rest.split())
+    return deps
+
+
+def level_chain(entries):
+    """同一等级内考虑依赖后的最长链, 返回 (长度, 链上的函数名)."""
+    by_name = {e.name: e for e in entries}
+    memo = {}
+
+    def finish(e, stack=()):
+        if e.name in memo:
+            return memo[e.name]
+        if e.name in stack:
+            raise ValueError("dependency cycle at %s" % e.name)
+        best = (0.0, [])
+        for dep in e.deps:
+            if dep in by_name:
+                t, chain = finish(by_name[dep], stack + (e.name,))
+                if t > best[0]:
+                    best = (t, chain)
+        memo[e.name] = (best[0] + e.time_us, best[1] + [e.name])
+        return memo[e.name]
+
+    best = (0.0, [])
+    for e in entries:
+        t, chain = finish(e)
+        if t > best[0]:
+            best = (t, chain)
+    return best
+
+
+def level_makespan(entries, workers):
+    """同一等级内的表调度: 就绪的函数中优先执行剩余链最长的, 与运行时的批量执行近似."""
+    if workers <= 1 or len(entries) <= 1:
+        return sum(e.time_us for e in entries)
+    by_name = {e.name: e for e in entries}
+    dependents = {e.name: [] for e in entries}
+    pending = {}
+    for e in entries:
+        local = [d for d in e.deps if d in by_name]
+        pending[e.name] = len(local)
+        for d in local:
+            dependents[d].append(e.name)
+
+    tail = {}
+
+    def tail_len(name):
+        if name not in tail:
+            tail[name] = by_name[name].time_us + max((tail_len(n) for n in dependents[name]), default=0.0)
+        return tail[name]
+
+    ready = [e.name for e in entries if pending[e.name] == 0]
+    running = []    # (结束时间, 函数名)
+    now = 0.0
+    done = 0
+    while done < len(entries):
+        ready.sort(key=tail_len, reverse=True)
+        while ready and len(running) < workers:
+            name = ready.pop(0)
+            running.append((now + by_name[name].time_us, name))
+        running.sort()
+        now, name = running.pop(0)
+        done += 1
+        for n in dependents[name]:
+            pending[n] -= 1
+            if pending[n] == 0:
+                ready.append(n)
+    return now
+
+
+def group(entries):
+    levels = {}
+    for e in entries:
+        levels.setdefault(e.level, []).append(e)
+    return levels
+
+
+def simulate(entries, workers):
+    return sum(level_makespan(es, workers) for es in group(entries).values())
+
+
+def suggest_moves(entries, workers, top):
+    """逐个尝试把函数移到其他等级, 按收益排序. 依赖约束: 不早于所依赖的函数, 不晚于依赖它的函数."""
+    by_name = {e.name: e for e in entries}
+    base = simulate(entries, workers)
+    moves = []
+    for e in entries:
+        lo = max([by_name[d].level for d in e.deps if d in by_name] + [LEVEL_FIRST])
+        hi = min([o.level for o in entries if e.name in o.deps] + [LEVEL_LAST])
+        origin = e.level
+        for level in range(lo, hi + 1):
+            if level == origin:
+                continue
+            e.level = level
+            gain = base - simulate(entries, workers)
+            if gain > 0:
+                moves.append((gain, e.name, origin, level))
+        e.level = origin
+    moves.sort(reverse=True)
+    return moves[:top]
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="xf_init offline boot-plan analyzer")
+    parser.add_argument("elf", help="linked image")
+    parser.add_argument("--profile", help="CSV from xf_init_stats_export()")
+    parser.add_argument("--deps", help="dependency file, lines of 'name: dep1 dep2'")
+    parser.add_argument("--workers", type=int, default=4, help="simulated worker count (default: 4)")
+    parser.add_argument("--top", type=int, default=5, help="number of suggested moves (default: 5)")
+    args = parser.parse_args(argv)
+
+    try:
+        mode, entries = load_plan(args.elf)
+    except (OSError, ElfError) as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+
+    profile = load_profile(args.profile) if args.profile else {}
+    deps = load_deps(args.deps) if args.deps else {}
+    for e in entries:
+        if e.name in profile:
+            level, e.time_us = profile[e.name]
+            if e.level == 0:
+                e.level = level
+        e.deps = deps.get(e.name, set())
+    missing = [e.name for e in entries if e.level == 0]
+    if missing:
+        print("warning: level unknown (not in profile), ignored: %s" % ", ".join(missing), file=sys.stderr)
+        entries = [e for e in entries if e.level != 0]
+
+    print("mode: %s, %d entries" % (mode, len(entries)))
+    print()
+    print("%-10s %-40s %12s" % ("level", "name", "time_us"))
+    for level, es in sorted(group(entries).items()):
+        for e in es:
+            print("%-10s %-40s %12.0f" % (LEVEL_NAMES[level], e.name, e.time_us))
+    if not profile:
+        return 0
+
+    try:
+        critical = 0.0
+        path = []
+        for level, es in sorted(group(entries).items()):
+            t, chain = level_chain(es)
+            critical += t
+            path += chain
+        serial = simulate(entries, 1)
+        parallel = simulate(entries, args.workers)
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+
+    print()
+    print("serial boot      : %12.0f us" % serial)
+    print("%2d workers       : %12.0f us" % (args.workers, parallel))
+    print("critical path    : %12.0f us" % critical)
+    print("  " + " -> ".join(path))
+
+    moves = suggest_moves(entries, args.workers, args.top)
+    if moves:
+        print()
+        print("suggested moves (%d workers):" % args.workers)
+        for gain, name, origin, level in moves:
+            print("  %-40s %-9s -> %-9s saves %10.0f us" % (name, LEVEL_NAMES[origin], LEVEL_NAMES[level], gain))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,6 +9,8 @@ target("xf_init")
     add_ldflags("-Tlinker/gcc_x86_64.xf_init.ld")
     add_files("src/**.c")
     add_files("example/*.c")
+    add_files("example/*.cpp")
     add_includedirs("example")
     add_includedirs("src")
+    add_syslinks("pthread")
     add_xf_utils("xf_utils")